@@ -23,4 +23,22 @@
 /* Code-offset fuzzy extractor using Niederreiter decrypt + SHAKE256. */
 #include "src/code_offset.c"
 
+/* Streaming (init/update/final) code-offset decode. */
+#include "src/code_offset_stream.c"
+
+/* Multi-capture fusion (bitsliced majority / weighted vote). */
+#include "src/capture_fusion.c"
+
+/* Template binarization / reliable-bit selection front-end. */
+#include "src/template_binarize.c"
+
+/* Shared system key in a process-shared segment. */
+#include "src/system_key.c"
+
+/* NUMA placement: node-local memory, key replicas, pinned worker pool. */
+#include "src/numa.c"
+
+/* Helper re-keying (key rotation without re-enrollment). */
+#include "src/rekey.c"
+
 /* All implementations live in the included modules. */
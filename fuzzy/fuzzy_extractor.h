@@ -14,6 +14,10 @@ extern "C" {
 #define MCELIECE_348864F_CIPHERTEXT_LEN 96
 #define MCELIECE_348864F_SHARED_SECRET_LEN 32
 
+/* Code-offset error-vector layout: SYS_N bits, packed LSB-first. */
+#define FUZZY_TEMPLATE_BITS 3488
+#define FUZZY_TEMPLATE_BYTES (FUZZY_TEMPLATE_BITS / 8)
+
 int fuzzy_generate_key(uint8_t *key_out, size_t key_len,
                        uint8_t *ciphertext_out,
                        uint8_t *public_key_out, uint8_t *secret_key_out);
@@ -51,6 +55,396 @@ int code_offset_encode(const uint8_t *w, size_t wlen,
 int code_offset_decode(const uint8_t *wprime, size_t wlen,
                        const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
                        uint8_t *key_out, size_t key_len);
+
+/* Low-stack encode/decode.
+ *
+ * Same results as code_offset_encode() against an existing key and
+ * code_offset_decode(), but the per-call working set (error vector,
+ * syndromes, Goppa output, key hash) lives in caller-provided scratch of at
+ * least CODE_OFFSET_SCRATCH_BYTES (any alignment) and is wiped before
+ * returning. McEliece key generation needs several hundred KB of stack inside
+ * PQClean, so the scratch encode takes an existing public key: generate keys
+ * on a large-stack thread (or use a system key) and enroll from small-stack
+ * threads. The Goppa decoder's own frame stays on the stack; see the memory
+ * budget below.
+ */
+#define CODE_OFFSET_SCRATCH_BYTES 1096
+
+int code_offset_encode_scratch(const uint8_t *w, size_t wlen,
+                               uint8_t *helper_out, const uint8_t *public_key,
+                               uint8_t *key_out, size_t key_len,
+                               void *scratch, size_t scratch_len);
+
+int code_offset_decode_scratch(const uint8_t *wprime, size_t wlen,
+                               const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                               uint8_t *key_out, size_t key_len,
+                               void *scratch, size_t scratch_len);
+
+/* Batched decode of `count` probes against one enrollment. Probe k is read
+ * from wprimes + k * wlen, its key goes to keys_out + k * key_len and its
+ * status (as code_offset_decode would return it) to rc_out[k]. Probes are
+ * processed in groups of CODE_OFFSET_BATCH_MAX that share one pass over the
+ * public key. Returns -1 on invalid arguments, 0 otherwise.
+ */
+#define CODE_OFFSET_BATCH_MAX 8
+
+int code_offset_decode_batch(const uint8_t *wprimes, size_t wlen, size_t count,
+                             const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                             uint8_t *keys_out, size_t key_len, int *rc_out);
+
+/* Shared system key.
+ *
+ * One tenant-wide McEliece keypair lives in a shared-memory segment that
+ * worker processes map read-only. Enrollment then only computes the 96-byte
+ * helper against it, and every verification reads the same (hot) public key.
+ *
+ * fuzzy_system_key_create(): generate a keypair into a new segment.
+ *   name != NULL -> POSIX shm object (mode 0600) other processes attach by name.
+ *   name == NULL -> Linux memfd, huge-page backed when available; share it via
+ *                   fuzzy_system_key_fd() (inheritance or SCM_RIGHTS).
+ * fuzzy_system_key_attach() / _attach_fd(): map an existing segment read-only.
+ * fuzzy_system_key_rotate(): owner only; builds and populates the new keypair
+ *   beside the live one, then publishes it under the same name and marks the
+ *   old segment retired. On failure the current generation is unchanged.
+ *   Helpers created under the old key cannot be decoded with the new one
+ *   (compare fuzzy_system_key_id()); the old generation stays intact until
+ *   released, see below. Fails while a previous retired generation is held.
+ * fuzzy_system_key_refresh(): attacher side; returns 1 if it re-attached to a
+ *   rotated key, 0 if still current, -1 on error (fd attachments must be
+ *   re-attached with the owner's new fd; a retired generation still held must
+ *   be released first).
+ * Rotate and refresh swap the handle's mapping while other threads may keep
+ *   encoding or decoding through it; the previous mapping is kept as the
+ *   handle's retired generation. Calls that manage the handle itself (rotate,
+ *   refresh, release*) must not run concurrently with each other.
+ * fuzzy_system_key_retired(): the retired generation kept by the last rotate
+ *   or refresh, or NULL. Usable with code_offset_decode_shared() and
+ *   code_offset_rekey_system() until it is released.
+ * fuzzy_system_key_release_retired(): drop the retired generation once no
+ *   thread decodes through it. The owner also wipes the old secret key in the
+ *   segment, so call it only after workers have refreshed and old helpers
+ *   have been re-keyed.
+ * fuzzy_system_key_release(): unmap (including any retired generation); the
+ *   owner also wipes the secret keys and unlinks the name.
+ *
+ * On Windows only process-local keys (name == NULL) are supported.
+ */
+#define FUZZY_SYSTEM_KEY_ID_LEN 16
+
+typedef struct fuzzy_system_key fuzzy_system_key;
+
+int fuzzy_system_key_create(fuzzy_system_key **out, const char *name);
+
+int fuzzy_system_key_attach(fuzzy_system_key **out, const char *name);
+
+int fuzzy_system_key_attach_fd(fuzzy_system_key **out, int fd);
+
+int fuzzy_system_key_fd(const fuzzy_system_key *sys);
+
+int fuzzy_system_key_rotate(fuzzy_system_key *sys);
+
+int fuzzy_system_key_refresh(fuzzy_system_key *sys);
+
+const fuzzy_system_key *fuzzy_system_key_retired(const fuzzy_system_key *sys);
+
+void fuzzy_system_key_release_retired(fuzzy_system_key *sys);
+
+void fuzzy_system_key_release(fuzzy_system_key *sys);
+
+int fuzzy_system_key_id(const fuzzy_system_key *sys, uint8_t *id_out /* FUZZY_SYSTEM_KEY_ID_LEN */);
+
+const uint8_t *fuzzy_system_key_public_key(const fuzzy_system_key *sys);
+
+size_t fuzzy_system_key_footprint(const fuzzy_system_key *sys, size_t *heap_out);
+
+int code_offset_encode_shared(const fuzzy_system_key *sys,
+                              const uint8_t *w, size_t wlen,
+                              uint8_t *helper_out,
+                              uint8_t *key_out, size_t key_len);
+
+int code_offset_decode_shared(const fuzzy_system_key *sys,
+                              const uint8_t *wprime, size_t wlen,
+                              const uint8_t *helper,
+                              uint8_t *key_out, size_t key_len);
+
+/* Streaming decode.
+ *
+ * For probes captured in chunks: init, then feed w' in order with update()
+ * as chunks arrive, then final(). Each update folds its bytes into the
+ * running syndrome s' = H e' using the matching public-key columns, so after
+ * the last chunk only the Goppa decode and the key hash remain. The result
+ * equals code_offset_decode() on the concatenated chunks (bytes past
+ * FUZZY_TEMPLATE_BYTES are ignored, missing bytes are zero). helper and keys
+ * must stay valid until final(), which always wipes the context. Fields are
+ * private.
+ */
+typedef struct {
+    uint8_t e_prime[FUZZY_TEMPLATE_BYTES];
+    uint8_t s_prime[MCELIECE_348864F_CIPHERTEXT_LEN];
+    size_t received;
+    const uint8_t *helper;
+    const uint8_t *public_key;
+    const uint8_t *secret_key;
+} code_offset_decode_ctx;
+
+int code_offset_decode_init(code_offset_decode_ctx *ctx,
+                            const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key);
+
+int code_offset_decode_init_shared(code_offset_decode_ctx *ctx, const fuzzy_system_key *sys,
+                                   const uint8_t *helper);
+
+int code_offset_decode_update(code_offset_decode_ctx *ctx, const uint8_t *chunk, size_t len);
+
+int code_offset_decode_final(code_offset_decode_ctx *ctx, uint8_t *key_out, size_t key_len);
+
+/* Multi-capture fusion.
+ *
+ * fuzzy_fuse_captures() combines k captures of w' (wlen bytes each) into one
+ * lower-noise vector by a per-bit vote: bit = 1 when the captures having it
+ * set carry more than half of the total weight; exact ties take capture 0's
+ * bit. weights == NULL is a plain majority vote, otherwise weights[c]
+ * (0..255, e.g. a sensor quality score) is capture c's vote. The vote is
+ * bitsliced (64 bit positions per word op) and branch-free on template bits.
+ *
+ * code_offset_decode_fused() fuses and decodes once. With
+ * FUZZY_FUSE_FALLBACK it then tries each capture individually, in order,
+ * until one decodes, skipping captures identical to the fused vector;
+ * *attempts_out (optional) receives the number of decodes performed. As
+ * with code_offset_decode(), rc == 0 means the syndrome decoded, not that
+ * the key matches the enrolled one.
+ */
+#define FUZZY_FUSION_MAX_CAPTURES 64
+#define FUZZY_FUSE_ONLY 0
+#define FUZZY_FUSE_FALLBACK 1
+
+int fuzzy_fuse_captures(uint8_t *fused_out,
+                        const uint8_t *const *captures, const uint8_t *weights,
+                        size_t k, size_t wlen);
+
+int code_offset_decode_fused(const uint8_t *const *captures, const uint8_t *weights,
+                             size_t k, size_t wlen, int mode,
+                             const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                             uint8_t *key_out, size_t key_len, int *attempts_out);
+
+/* NUMA placement.
+ *
+ * fuzzy_numa_alloc() returns zeroed, page-aligned memory placed on `node`
+ * (node < 0: the calling thread's node); release it with fuzzy_numa_free(),
+ * which wipes it. Use it for per-enrollment keys and scratch arenas that one
+ * node reads hot. fuzzy_numa_node_of() reports the node backing an address
+ * (-1 when unknown; Linux only on multi-node hosts).
+ *
+ * fuzzy_key_replicas keeps one node-local copy of a hot shared keypair
+ * (e.g. a system key) per node; code_offset_decode_replicated() reads the
+ * copy on the caller's current node. Replicas are private snapshots: they do
+ * not follow fuzzy_system_key_rotate(). fuzzy_key_replicas_id() returns the
+ * same id as fuzzy_system_key_id() for the key they were made from; rebuild
+ * the replicas when the two differ.
+ *
+ * fuzzy_numa_pool runs threads_per_node workers pinned to each node's CPUs,
+ * each with a node-local scratch arena of scratch_len bytes passed to its
+ * tasks (NULL when scratch_len is 0). fuzzy_numa_pool_create() allocates the
+ * arenas before starting the workers and fails with -1 if any allocation
+ * fails. fuzzy_numa_pool_submit() queues a task on `node` (node < 0: round
+ * robin) and blocks while that node's queue is full; it returns the node used
+ * or -1. fuzzy_numa_pool_submit_near() routes to the node owning `data`, e.g.
+ * the enrollment's public key.
+ *
+ * Single-node hosts (and platforms without NUMA support) report one node.
+ */
+typedef struct fuzzy_key_replicas fuzzy_key_replicas;
+typedef struct fuzzy_numa_pool fuzzy_numa_pool;
+typedef void (*fuzzy_numa_task_fn)(void *arg, int node, void *scratch, size_t scratch_len);
+
+int fuzzy_numa_node_count(void);
+
+int fuzzy_numa_current_node(void);
+
+int fuzzy_numa_node_of(const void *addr);
+
+int fuzzy_numa_bind_thread(int node);
+
+void *fuzzy_numa_alloc(size_t len, int node);
+
+void fuzzy_numa_free(void *p, size_t len);
+
+int fuzzy_key_replicas_create(fuzzy_key_replicas **out, const uint8_t *public_key, const uint8_t *secret_key);
+
+void fuzzy_key_replicas_release(fuzzy_key_replicas *r);
+
+int fuzzy_key_replicas_id(const fuzzy_key_replicas *r, uint8_t *id_out /* FUZZY_SYSTEM_KEY_ID_LEN */);
+
+size_t fuzzy_key_replicas_footprint(const fuzzy_key_replicas *r, size_t *heap_out);
+
+const uint8_t *fuzzy_key_replicas_public_key(const fuzzy_key_replicas *r, int node);
+
+const uint8_t *fuzzy_key_replicas_secret_key(const fuzzy_key_replicas *r, int node);
+
+int code_offset_decode_replicated(const fuzzy_key_replicas *r,
+                                  const uint8_t *wprime, size_t wlen,
+                                  const uint8_t *helper,
+                                  uint8_t *key_out, size_t key_len);
+
+int fuzzy_numa_pool_create(fuzzy_numa_pool **out, int threads_per_node,
+                           size_t queue_depth, size_t scratch_len);
+
+int fuzzy_numa_pool_submit(fuzzy_numa_pool *pool, int node, fuzzy_numa_task_fn fn, void *arg);
+
+int fuzzy_numa_pool_submit_near(fuzzy_numa_pool *pool, const void *data, fuzzy_numa_task_fn fn, void *arg);
+
+void fuzzy_numa_pool_wait(fuzzy_numa_pool *pool);
+
+size_t fuzzy_numa_pool_footprint(const fuzzy_numa_pool *pool, size_t *heap_out);
+
+void fuzzy_numa_pool_destroy(fuzzy_numa_pool *pool);
+
+/* Template binarization front-end.
+ *
+ * Real-valued feature vectors (n features) are quantized to one bit per
+ * feature (bit = x[i] > thresholds[i]; thresholds == NULL means 0) and the
+ * features selected by `mask` are packed LSB-first into a
+ * FUZZY_TEMPLATE_BYTES error vector, zero-padded. `mask` is a per-enrollment
+ * bitmap of (n + 7) / 8 bytes (NULL selects every feature); it is helper
+ * data and must be stored next to the McEliece helper. At most
+ * FUZZY_TEMPLATE_BITS features may be selected.
+ *
+ * fuzzy_reliable_mask_*() builds that mask at enrollment from `count`
+ * captures (row-major, n features each), keeping the n_select features whose
+ * mean distance to the threshold is largest.
+ */
+int fuzzy_reliable_mask_f32(uint8_t *mask_out, const float *x, size_t count,
+                            const float *thresholds, size_t n, size_t n_select);
+
+int fuzzy_reliable_mask_i16(uint8_t *mask_out, const int16_t *x, size_t count,
+                            const int16_t *thresholds, size_t n, size_t n_select);
+
+int fuzzy_binarize_f32(uint8_t *e_out, /* FUZZY_TEMPLATE_BYTES */
+                       const float *x, const float *thresholds,
+                       const uint8_t *mask, size_t n);
+
+int fuzzy_binarize_i16(uint8_t *e_out, /* FUZZY_TEMPLATE_BYTES */
+                       const int16_t *x, const int16_t *thresholds,
+                       const uint8_t *mask, size_t n);
+
+/* Batch variants: `x` holds `count` row-major samples of n features and
+ * e_out receives count * FUZZY_TEMPLATE_BYTES bytes.
+ */
+int fuzzy_binarize_f32_batch(uint8_t *e_out, const float *x, size_t count,
+                             const float *thresholds, const uint8_t *mask, size_t n);
+
+int fuzzy_binarize_i16_batch(uint8_t *e_out, const int16_t *x, size_t count,
+                             const int16_t *thresholds, const uint8_t *mask, size_t n);
+
+/* Code-offset entry points that binarize straight into the internal error
+ * vector (no caller-side template buffer).
+ */
+int code_offset_encode_f32(const float *x, const float *thresholds,
+                           const uint8_t *mask, size_t n,
+                           uint8_t *helper_out,
+                           uint8_t *public_key_out, uint8_t *secret_key_out,
+                           uint8_t *key_out, size_t key_len);
+
+int code_offset_decode_f32(const float *x, const float *thresholds,
+                           const uint8_t *mask, size_t n,
+                           const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                           uint8_t *key_out, size_t key_len);
+
+int code_offset_encode_i16(const int16_t *x, const int16_t *thresholds,
+                           const uint8_t *mask, size_t n,
+                           uint8_t *helper_out,
+                           uint8_t *public_key_out, uint8_t *secret_key_out,
+                           uint8_t *key_out, size_t key_len);
+
+int code_offset_decode_i16(const int16_t *x, const int16_t *thresholds,
+                           const uint8_t *mask, size_t n,
+                           const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                           uint8_t *key_out, size_t key_len);
+
+/* Helper re-keying (key rotation without re-enrollment).
+ *
+ * Privileged operation: given a fresh sample w' of an enrolled user, recover
+ * the enrolled error vector e under the old key pair and emit a new helper
+ * for the same e under another public key. The derived key is unchanged, so
+ * anything wrapped under it stays valid. Returns the decode rc when w' is too
+ * far from the enrolled template (new_helper_out is then untouched). key_out
+ * is optional (NULL skips it); when given it receives the unchanged key.
+ * e and all intermediate syndromes are wiped before returning.
+ *
+ * _keygen generates a fresh per-enrollment key pair for the new helper,
+ * _shared targets the public key of a system key, and _system moves a helper
+ * made under one system key to another, typically from
+ * fuzzy_system_key_retired() to the rotated key before the retired
+ * generation is released.
+ */
+int code_offset_rekey(const uint8_t *wprime, size_t wlen,
+                      const uint8_t *old_helper, const uint8_t *old_public_key, const uint8_t *old_secret_key,
+                      const uint8_t *new_public_key,
+                      uint8_t *new_helper_out,
+                      uint8_t *key_out, size_t key_len);
+
+int code_offset_rekey_keygen(const uint8_t *wprime, size_t wlen,
+                             const uint8_t *old_helper, const uint8_t *old_public_key, const uint8_t *old_secret_key,
+                             uint8_t *new_helper_out,
+                             uint8_t *new_public_key_out, uint8_t *new_secret_key_out,
+                             uint8_t *key_out, size_t key_len);
+
+int code_offset_rekey_shared(const uint8_t *wprime, size_t wlen,
+                             const uint8_t *old_helper, const uint8_t *old_public_key, const uint8_t *old_secret_key,
+                             const fuzzy_system_key *sys,
+                             uint8_t *new_helper_out,
+                             uint8_t *key_out, size_t key_len);
+
+int code_offset_rekey_system(const uint8_t *wprime, size_t wlen,
+                             const uint8_t *old_helper, const fuzzy_system_key *old_sys,
+                             const fuzzy_system_key *new_sys,
+                             uint8_t *new_helper_out,
+                             uint8_t *key_out, size_t key_len);
+
+/* Memory budget per entry point (checked by tests/footprint).
+ *
+ * Peak stack of one call, PQClean / liboqs frames included:
+ *   KEYGEN  calls that generate a McEliece keypair: code_offset_encode(),
+ *           code_offset_encode_f32() / _i16(), code_offset_rekey_keygen(),
+ *           mceliece_kem_encode_like(), fuzzy_generate_key(),
+ *           fuzzy_system_key_create() / _rotate().
+ *   DECODE  calls that run one Goppa decode: code_offset_decode() and its
+ *           _shared, _replicated, _fused, _f32 / _i16 and _scratch forms,
+ *           code_offset_decode_final(), code_offset_rekey() / _rekey_shared() /
+ *           _rekey_system(),
+ *           mceliece_kem_decode_like(), fuzzy_reconstruct_key().
+ *   BATCH   code_offset_decode_batch().
+ *   LIGHT   everything else: code_offset_encode_shared() / _encode_scratch(),
+ *           streaming init / update, fusion, binarization, reliable masks,
+ *           system-key attach / refresh / release, NUMA and pool calls.
+ *
+ * Each budget is the class's peak stack plus 25%, rounded up to 4 KB. Library
+ * frames were measured with tests/footprint (gcc -O2, x86-64 Linux, PQClean
+ * stubbed out); PQClean frames are the stack arrays its mceliece348864f
+ * sources declare on the deepest path:
+ *   class    library  PQClean                                    peak     budget
+ *   KEYGEN    3.3 KB  424.4 KB kem_keypair + pk_gen + mov_columns 427.7 KB 536 KB
+ *   DECODE    1.9 KB   21.4 KB decrypt + support_gen               23.3 KB  32 KB
+ *   BATCH     5.0 KB   21.4 KB decrypt + support_gen               26.3 KB  36 KB
+ *   LIGHT     7.5 KB    0.6 KB SHAKE256 (replica key id)             8.1 KB  12 KB
+ * `footprint -calibrate` prints the same derivation from a run against the
+ * real liboqs; update the values from it when PQClean or the compiler
+ * changes.
+ *
+ * Heap: encode, decode and re-key never allocate. fuzzy_reliable_mask_*()
+ * holds 16 bytes per feature for the duration of the call. A system key maps
+ * one segment (4 KB header + keypair, rounded to 4 KB or to one huge page)
+ * plus the retired generation after a rotation, key replicas one keypair per
+ * node and a pool one queue per node plus a scratch arena per worker, until
+ * the matching _release() / _destroy(). fuzzy_system_key_footprint(),
+ * fuzzy_key_replicas_footprint() and fuzzy_numa_pool_footprint() return the
+ * bytes a live handle maps and store its heap bytes in *heap_out (optional);
+ * NULL handles hold nothing.
+ */
+#define FUZZY_STACK_BUDGET_KEYGEN (536u * 1024u)
+#define FUZZY_STACK_BUDGET_DECODE (32u * 1024u)
+#define FUZZY_STACK_BUDGET_BATCH (36u * 1024u)
+#define FUZZY_STACK_BUDGET_LIGHT (12u * 1024u)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: MIT
+
+#include "../fuzzy_extractor.h"
+#include "code_offset_internal.h"
+
+#include <string.h>
+#include <stdint.h>
+
+/* --- Multi-capture fusion: bitsliced (weighted) majority vote over k probes --- */
+
+/* Each lane carries one bit position, so a 256-bit vector holds 256
+ * independent votes. Per-position vote totals are kept as bit planes (plane
+ * j = bit j of every lane's total) and updated with a ripple-carry adder;
+ * adding one capture costs a few vector ops per plane regardless of its
+ * content. The comparison against half the total weight is done on the
+ * planes as well, leaving no branch or table lookup on template bits.
+ * GCC vector extensions lower to SSE2 by default and AVX2 with -mavx2.
+ */
+#define FUSION_PLANES 16   /* 64 captures * 255 < 2^16 */
+#define FUSION_BLOCK 32    /* bytes per vector */
+
+typedef uint64_t fusion_vec __attribute__((vector_size(FUSION_BLOCK)));
+
+/* Vectors are passed by pointer to keep the ABI independent of -mavx. */
+static inline void fusion_load(fusion_vec *v, const uint8_t *p, size_t avail) {
+    if (avail >= FUSION_BLOCK) {
+        memcpy(v, p, FUSION_BLOCK);
+    } else {
+        memset(v, 0, FUSION_BLOCK);
+        memcpy(v, p, avail);
+    }
+}
+
+static inline void fusion_store(uint8_t *p, size_t avail, const fusion_vec *v) {
+    memcpy(p, v, (avail >= FUSION_BLOCK) ? FUSION_BLOCK : avail);
+}
+
+static unsigned fusion_plane_count(uint32_t total) {
+    unsigned n = 1;
+    while (n < FUSION_PLANES && (total >> n) != 0) n++;
+    return n;
+}
+
+/* fused = (2 * sum > total) | (2 * sum == total & capture0), lane-wise. */
+static void fusion_decide(fusion_vec *out, const fusion_vec *planes, unsigned nplanes, uint32_t total,
+                          const fusion_vec *first) {
+    uint32_t half = total / 2;
+    fusion_vec zero = { 0 };
+    fusion_vec gt = zero;
+    fusion_vec eq = ~zero;
+    for (unsigned j = nplanes; j-- > 0;) {
+        uint64_t hb = ((half >> j) & 1u) ? ~(uint64_t)0 : 0;
+        gt |= eq & planes[j] & ~hb;
+        eq &= ~(planes[j] ^ hb);
+    }
+    fusion_vec tie = (total & 1u) ? zero : eq;
+    *out = gt | (tie & *first);
+}
+
+int fuzzy_fuse_captures(uint8_t *fused_out,
+                        const uint8_t *const *captures, const uint8_t *weights,
+                        size_t k, size_t wlen) {
+    if (fused_out == NULL || captures == NULL || k == 0 || k > FUZZY_FUSION_MAX_CAPTURES) return -1;
+    for (size_t c = 0; c < k; c++) {
+        if (captures[c] == NULL && wlen > 0) return -1;
+    }
+
+    uint32_t total = 0;
+    for (size_t c = 0; c < k; c++) total += weights ? weights[c] : 1u;
+    if (total == 0) return -1;
+    unsigned nplanes = fusion_plane_count(total);
+
+    fusion_vec planes[FUSION_PLANES];
+    for (size_t off = 0; off < wlen; off += FUSION_BLOCK) {
+        size_t avail = wlen - off;
+        memset(planes, 0, sizeof(planes));
+
+        for (size_t c = 0; c < k; c++) {
+            fusion_vec x;
+            fusion_load(&x, captures[c] + off, avail);
+            uint32_t wgt = weights ? weights[c] : 1u;
+            fusion_vec carry = { 0 };
+            for (unsigned j = 0; j < nplanes; j++) {
+                fusion_vec a = x & (((wgt >> j) & 1u) ? ~(uint64_t)0 : 0);
+                fusion_vec p = planes[j];
+                planes[j] = p ^ a ^ carry;
+                carry = (p & a) | (carry & (p ^ a));
+            }
+        }
+
+        fusion_vec first, fused;
+        fusion_load(&first, captures[0] + off, avail);
+        fusion_decide(&fused, planes, nplanes, total, &first);
+        fusion_store(fused_out + off, avail, &fused);
+    }
+    secure_memzero(planes, sizeof(planes));
+    return 0;
+}
+
+int code_offset_decode_fused(const uint8_t *const *captures, const uint8_t *weights,
+                             size_t k, size_t wlen, int mode,
+                             const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                             uint8_t *key_out, size_t key_len, int *attempts_out) {
+    if (attempts_out != NULL) *attempts_out = 0;
+    if (helper == NULL || public_key == NULL || secret_key == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+    if (mode != FUZZY_FUSE_ONLY && mode != FUZZY_FUSE_FALLBACK) return -1;
+
+    /* Only the part of w' that reaches e' needs to be fused. */
+    size_t flen = (wlen >= SYS_N_BYTES) ? SYS_N_BYTES : wlen;
+    unsigned char e_prime[SYS_N_BYTES];
+    memset(e_prime, 0, SYS_N_BYTES);
+    if (fuzzy_fuse_captures(e_prime, captures, weights, k, flen) != 0) return -1;
+
+    /* decode_evec wipes e_prime; keep the fused vector for the fallback. */
+    unsigned char fused[SYS_N_BYTES];
+    if (mode == FUZZY_FUSE_FALLBACK) memcpy(fused, e_prime, SYS_N_BYTES);
+
+    int attempts = 1;
+    int rc = code_offset_decode_evec(e_prime, helper, public_key, secret_key, key_out, key_len);
+
+    if (rc != 0 && mode == FUZZY_FUSE_FALLBACK) {
+        for (size_t c = 0; c < k && rc != 0; c++) {
+            /* A capture equal to the fused vector (k == 1, or capture 0 winning
+             * every tie when k == 2) would only repeat the failed decode. */
+            code_offset_load_template(e_prime, captures[c], wlen);
+            if (constant_time_compare(e_prime, fused, SYS_N_BYTES)) continue;
+            attempts++;
+            rc = code_offset_decode_evec(e_prime, helper, public_key, secret_key, key_out, key_len);
+        }
+        secure_memzero(e_prime, SYS_N_BYTES);
+    }
+    if (mode == FUZZY_FUSE_FALLBACK) secure_memzero(fused, SYS_N_BYTES);
+
+    if (attempts_out != NULL) *attempts_out = attempts;
+    return rc;
+}
@@ -2,6 +2,7 @@
 
 #include "../fuzzy_extractor.h"
 #include "oqs_pqclean_decls.h"
+#include "code_offset_internal.h"
 
 #include <oqs/sha3.h>
 
@@ -16,44 +17,24 @@
 #endif
 
 /* --- Code-Offset implementation using low-level McEliece encrypt/decrypt --- */
-/* SYS_N and byte size for error vectors (from params.h: 3488) */
-#define SYS_N_BITS 3488
-#define SYS_N_BYTES (SYS_N_BITS / 8)
-
-/* Constants matching pqclean params.h */
-#define SYS_T 64
-#define GFBITS 12
-#define PK_NROWS (SYS_T * GFBITS)
-#define PK_NCOLS (SYS_N_BITS - PK_NROWS)
-#define PK_ROW_BYTES ((PK_NCOLS + 7) / 8)
-#define SYND_BYTES ((PK_NROWS + 7) / 8)
 
 /* Compute Niederreiter ciphertext (syndrome) for a caller-provided error vector `e`.
- * This reproduces PQClean's internal syndrome routine (encrypt.c) but takes `e` from caller.
+ * Same result as PQClean's internal syndrome routine (encrypt.c), but row i of
+ * H = [I | pk] is applied in place: the identity part is bit i of e and the pk
+ * row covers e bytes SYND_BYTES..SYS_N_BYTES-1, so no row buffer is built.
  */
-static void compute_syndrome(unsigned char *s, const unsigned char *pk, const unsigned char *e) {
-    unsigned char b;
-    unsigned char row[SYS_N_BYTES];
+static void code_offset_compute_syndrome(unsigned char *s, const unsigned char *pk, const unsigned char *e) {
     const unsigned char *pk_ptr = pk;
+    const unsigned char *e_tail = e + SYND_BYTES;
 
     for (int i = 0; i < SYND_BYTES; i++) {
         s[i] = 0;
     }
 
     for (int i = 0; i < PK_NROWS; i++) {
-        for (int j = 0; j < SYS_N_BYTES; j++) {
-            row[j] = 0;
-        }
-
+        unsigned char b = (unsigned char)((e[i / 8] >> (i % 8)) & 1u);
         for (int j = 0; j < PK_ROW_BYTES; j++) {
-            row[SYS_N_BYTES - PK_ROW_BYTES + j] = pk_ptr[j];
-        }
-
-        row[i / 8] |= (unsigned char)(1u << (i % 8));
-
-        b = 0;
-        for (int j = 0; j < SYS_N_BYTES; j++) {
-            b ^= (unsigned char)(row[j] & e[j]);
+            b ^= (unsigned char)(pk_ptr[j] & e_tail[j]);
         }
 
         b ^= (unsigned char)(b >> 4);
@@ -67,30 +48,21 @@ static void compute_syndrome(unsigned char *s, const unsigned char *pk, const un
     }
 }
 
-int code_offset_encode(const uint8_t *w, size_t wlen,
-                       uint8_t *helper_out,
-                       uint8_t *public_key_out, uint8_t *secret_key_out,
-                       uint8_t *key_out, size_t key_len) {
-    if (helper_out == NULL || public_key_out == NULL || secret_key_out == NULL || key_out == NULL) return -1;
-    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
-
-    FUZZY_DPRINTF("code_offset_encode: start (key_len=%zu, wlen=%zu)\n", key_len, wlen);
-
-    int rc = PQCLEAN_MCELIECE348864F_CLEAN_crypto_kem_keypair(public_key_out, secret_key_out);
-    if (rc != 0) return rc;
-
-    /* Map w into the error vector with zero-padding to preserve Hamming distance. */
-    unsigned char e_vec[SYS_N_BYTES];
-    memset(e_vec, 0, SYS_N_BYTES);
+static void code_offset_load_template(unsigned char *e, const uint8_t *w, size_t wlen) {
+    memset(e, 0, SYS_N_BYTES);
     if (w != NULL) {
         if (wlen >= SYS_N_BYTES) {
-            memcpy(e_vec, w, SYS_N_BYTES);
+            memcpy(e, w, SYS_N_BYTES);
         } else if (wlen > 0) {
-            memcpy(e_vec, w, wlen);
+            memcpy(e, w, wlen);
         }
     }
+}
 
-    compute_syndrome(helper_out, public_key_out, e_vec);
+static int code_offset_encode_evec_pk(unsigned char *e_vec,
+                                      uint8_t *helper_out, const uint8_t *public_key,
+                                      uint8_t *key_out, size_t key_len) {
+    code_offset_compute_syndrome(helper_out, public_key, e_vec);
 
     /* Derive stable key from e via SHAKE256. */
     uint8_t shared[MCELIECE_348864F_SHARED_SECRET_LEN];
@@ -102,60 +74,237 @@ int code_offset_encode(const uint8_t *w, size_t wlen,
     return 0;
 }
 
-int code_offset_decode(const uint8_t *wprime, size_t wlen,
-                       const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+static int code_offset_encode_evec(unsigned char *e_vec,
+                                   uint8_t *helper_out,
+                                   uint8_t *public_key_out, uint8_t *secret_key_out,
+                                   uint8_t *key_out, size_t key_len) {
+    int rc = PQCLEAN_MCELIECE348864F_CLEAN_crypto_kem_keypair(public_key_out, secret_key_out);
+    if (rc != 0) {
+        secure_memzero(e_vec, SYS_N_BYTES);
+        return rc;
+    }
+
+    return code_offset_encode_evec_pk(e_vec, helper_out, public_key_out, key_out, key_len);
+}
+
+int code_offset_encode(const uint8_t *w, size_t wlen,
+                       uint8_t *helper_out,
+                       uint8_t *public_key_out, uint8_t *secret_key_out,
                        uint8_t *key_out, size_t key_len) {
-    if (helper == NULL || public_key == NULL || secret_key == NULL || key_out == NULL) return -1;
+    if (helper_out == NULL || public_key_out == NULL || secret_key_out == NULL || key_out == NULL) return -1;
     if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
 
-    /* Step 1: map w' to an error vector e' (zero-pad) */
-    unsigned char e_prime[SYS_N_BYTES];
-    memset(e_prime, 0, SYS_N_BYTES);
-    if (wprime != NULL) {
-        if (wlen >= SYS_N_BYTES) {
-            memcpy(e_prime, wprime, SYS_N_BYTES);
-        } else if (wlen > 0) {
-            memcpy(e_prime, wprime, wlen);
-        }
-    }
+    FUZZY_DPRINTF("code_offset_encode: start (key_len=%zu, wlen=%zu)\n", key_len, wlen);
 
-    /* Step 2: s' = H e' */
-    unsigned char s_prime[SYND_BYTES];
-    compute_syndrome(s_prime, public_key, e_prime);
+    /* Map w into the error vector with zero-padding to preserve Hamming distance. */
+    unsigned char e_vec[SYS_N_BYTES];
+    code_offset_load_template(e_vec, w, wlen);
+
+    return code_offset_encode_evec(e_vec, helper_out, public_key_out, secret_key_out, key_out, key_len);
+}
 
+/* Steps 3-5 with caller-provided work buffers (SYND_BYTES / SYS_N_BYTES).
+ * s_delta and error_diff are wiped on both the success and failure paths;
+ * code_offset_recover_evec() relies on this for its stack copies. */
+static int recover_evec_into(unsigned char *e, const unsigned char *s_prime,
+                             const uint8_t *helper, const uint8_t *secret_key,
+                             unsigned char *s_delta, unsigned char *error_diff) {
     /* Step 3: s_delta = helper XOR s' */
-    unsigned char s_delta[SYND_BYTES];
     for (int i = 0; i < SYND_BYTES; i++) {
         s_delta[i] = helper[i] ^ s_prime[i];
     }
 
     /* Step 4: decode s_delta -> error_diff */
-    unsigned char error_diff[SYS_N_BYTES];
-
-    /* PQClean KEM secret key contains Niederreiter secret key starting at +40. */
-    const unsigned char *sk_niederreiter = (const unsigned char *)secret_key + 40;
+    const unsigned char *sk_niederreiter = (const unsigned char *)secret_key + SK_NIEDERREITER_OFFSET;
     int rc = PQCLEAN_MCELIECE348864F_CLEAN_decrypt(error_diff, sk_niederreiter, s_delta);
     if (rc != 0) {
-        secure_memzero(error_diff, sizeof(error_diff));
-        secure_memzero(e_prime, SYS_N_BYTES);
+        secure_memzero(error_diff, SYS_N_BYTES);
+        secure_memzero(s_delta, SYND_BYTES);
+        secure_memzero(e, SYS_N_BYTES);
         return rc;
     }
 
-    /* Step 5: recover e = e' XOR error_diff */
-    unsigned char e_recovered[SYS_N_BYTES];
+    /* Step 5: recover e = e' XOR error_diff (in place) */
     for (int i = 0; i < SYS_N_BYTES; i++) {
-        e_recovered[i] = e_prime[i] ^ error_diff[i];
+        e[i] ^= error_diff[i];
     }
 
+    secure_memzero(error_diff, SYS_N_BYTES);
+    secure_memzero(s_delta, SYND_BYTES);
+    return 0;
+}
+
+static int code_offset_recover_evec(unsigned char *e, const unsigned char *s_prime,
+                                    const uint8_t *helper, const uint8_t *secret_key) {
+    unsigned char s_delta[SYND_BYTES];
+    unsigned char error_diff[SYS_N_BYTES];
+    return recover_evec_into(e, s_prime, helper, secret_key, s_delta, error_diff);
+}
+
+static int code_offset_decode_syndrome(unsigned char *e_prime, const unsigned char *s_prime,
+                                       const uint8_t *helper, const uint8_t *secret_key,
+                                       uint8_t *key_out, size_t key_len) {
+    int rc = code_offset_recover_evec(e_prime, s_prime, helper, secret_key);
+    if (rc != 0) return rc;
+
     /* Step 6: derive key from recovered e */
     uint8_t shared[MCELIECE_348864F_SHARED_SECRET_LEN];
-    OQS_SHA3_shake256(shared, MCELIECE_348864F_SHARED_SECRET_LEN, e_recovered, SYS_N_BYTES);
+    OQS_SHA3_shake256(shared, MCELIECE_348864F_SHARED_SECRET_LEN, e_prime, SYS_N_BYTES);
     memcpy(key_out, shared, key_len);
 
     secure_memzero(shared, sizeof(shared));
-    secure_memzero(e_recovered, SYS_N_BYTES);
-    secure_memzero(error_diff, SYS_N_BYTES);
     secure_memzero(e_prime, SYS_N_BYTES);
 
     return 0;
 }
+
+static int code_offset_decode_evec(unsigned char *e_prime,
+                                   const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                                   uint8_t *key_out, size_t key_len) {
+    /* Step 2: s' = H e' */
+    unsigned char s_prime[SYND_BYTES];
+    code_offset_compute_syndrome(s_prime, public_key, e_prime);
+
+    return code_offset_decode_syndrome(e_prime, s_prime, helper, secret_key, key_out, key_len);
+}
+
+int code_offset_decode(const uint8_t *wprime, size_t wlen,
+                       const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                       uint8_t *key_out, size_t key_len) {
+    if (helper == NULL || public_key == NULL || secret_key == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+
+    /* Step 1: map w' to an error vector e' (zero-pad) */
+    unsigned char e_prime[SYS_N_BYTES];
+    code_offset_load_template(e_prime, wprime, wlen);
+
+    return code_offset_decode_evec(e_prime, helper, public_key, secret_key, key_out, key_len);
+}
+
+/* --- Low-stack variants: the whole working set lives in caller scratch --- */
+
+typedef struct {
+    unsigned char e[SYS_N_BYTES];
+    unsigned char error_diff[SYS_N_BYTES];
+    unsigned char s_prime[SYND_BYTES];
+    unsigned char s_delta[SYND_BYTES];
+    uint8_t shared[MCELIECE_348864F_SHARED_SECRET_LEN];
+} code_offset_scratch;
+
+/* CODE_OFFSET_SCRATCH_BYTES (public) must cover the working set. */
+typedef char code_offset_scratch_fits[(sizeof(code_offset_scratch) <= CODE_OFFSET_SCRATCH_BYTES) ? 1 : -1];
+
+int code_offset_encode_scratch(const uint8_t *w, size_t wlen,
+                               uint8_t *helper_out, const uint8_t *public_key,
+                               uint8_t *key_out, size_t key_len,
+                               void *scratch, size_t scratch_len) {
+    if (helper_out == NULL || public_key == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+    if (scratch == NULL || scratch_len < CODE_OFFSET_SCRATCH_BYTES) return -1;
+
+    code_offset_scratch *ws = (code_offset_scratch *)scratch;
+    code_offset_load_template(ws->e, w, wlen);
+    code_offset_compute_syndrome(helper_out, public_key, ws->e);
+    OQS_SHA3_shake256(ws->shared, MCELIECE_348864F_SHARED_SECRET_LEN, ws->e, SYS_N_BYTES);
+    memcpy(key_out, ws->shared, key_len);
+
+    secure_memzero(ws, sizeof(*ws));
+    return 0;
+}
+
+int code_offset_decode_scratch(const uint8_t *wprime, size_t wlen,
+                               const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                               uint8_t *key_out, size_t key_len,
+                               void *scratch, size_t scratch_len) {
+    if (helper == NULL || public_key == NULL || secret_key == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+    if (scratch == NULL || scratch_len < CODE_OFFSET_SCRATCH_BYTES) return -1;
+
+    code_offset_scratch *ws = (code_offset_scratch *)scratch;
+    code_offset_load_template(ws->e, wprime, wlen);
+    code_offset_compute_syndrome(ws->s_prime, public_key, ws->e);
+
+    int rc = recover_evec_into(ws->e, ws->s_prime, helper, secret_key, ws->s_delta, ws->error_diff);
+    if (rc == 0) {
+        OQS_SHA3_shake256(ws->shared, MCELIECE_348864F_SHARED_SECRET_LEN, ws->e, SYS_N_BYTES);
+        memcpy(key_out, ws->shared, key_len);
+    }
+
+    secure_memzero(ws, sizeof(*ws));
+    return rc;
+}
+
+/* Batched syndromes: every pk row is read once and applied to all probes
+ * while it is hot in L1, instead of streaming the 261 KB key per probe.
+ * Row i of H is [identity bit i | pk row i], so the identity part is just
+ * bit i of e and the pk part covers e bytes SYND_BYTES..SYS_N_BYTES-1.
+ */
+static void compute_syndrome_batch(unsigned char (*s)[SYND_BYTES], const unsigned char *pk,
+                                   unsigned char (*e)[SYS_N_BYTES], size_t count) {
+    const unsigned char *pk_ptr = pk;
+
+    for (size_t k = 0; k < count; k++) {
+        memset(s[k], 0, SYND_BYTES);
+    }
+
+    for (int i = 0; i < PK_NROWS; i++) {
+        for (size_t k = 0; k < count; k++) {
+            const unsigned char *ek = e[k] + SYND_BYTES;
+            uint64_t acc = 0;
+            int j = 0;
+            for (; j + 8 <= PK_ROW_BYTES; j += 8) {
+                uint64_t a, b;
+                memcpy(&a, pk_ptr + j, 8);
+                memcpy(&b, ek + j, 8);
+                acc ^= a & b;
+            }
+            for (; j < PK_ROW_BYTES; j++) {
+                acc ^= (uint64_t)(pk_ptr[j] & ek[j]);
+            }
+            acc ^= (uint64_t)((e[k][i / 8] >> (i % 8)) & 1u);
+
+            acc ^= acc >> 32;
+            acc ^= acc >> 16;
+            acc ^= acc >> 8;
+            acc ^= acc >> 4;
+            acc ^= acc >> 2;
+            acc ^= acc >> 1;
+
+            s[k][i / 8] |= (unsigned char)((acc & 1u) << (i % 8));
+        }
+        pk_ptr += PK_ROW_BYTES;
+    }
+}
+
+int code_offset_decode_batch(const uint8_t *wprimes, size_t wlen, size_t count,
+                             const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                             uint8_t *keys_out, size_t key_len, int *rc_out) {
+    if (helper == NULL || public_key == NULL || secret_key == NULL || keys_out == NULL || rc_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+    if (wprimes == NULL && wlen > 0 && count > 0) return -1;
+
+    unsigned char e_prime[CODE_OFFSET_BATCH_MAX][SYS_N_BYTES];
+    unsigned char s_prime[CODE_OFFSET_BATCH_MAX][SYND_BYTES];
+    size_t copy = (wlen >= SYS_N_BYTES) ? SYS_N_BYTES : wlen;
+
+    for (size_t base = 0; base < count; base += CODE_OFFSET_BATCH_MAX) {
+        size_t n = count - base;
+        if (n > CODE_OFFSET_BATCH_MAX) n = CODE_OFFSET_BATCH_MAX;
+
+        /* Step 1 for the whole group: map each w' to e' (zero-pad) */
+        for (size_t k = 0; k < n; k++) {
+            memset(e_prime[k], 0, SYS_N_BYTES);
+            if (copy > 0) memcpy(e_prime[k], wprimes + (base + k) * wlen, copy);
+        }
+
+        compute_syndrome_batch(s_prime, public_key, e_prime, n);
+
+        for (size_t k = 0; k < n; k++) {
+            rc_out[base + k] = code_offset_decode_syndrome(e_prime[k], s_prime[k], helper, secret_key,
+                                                           keys_out + (base + k) * key_len, key_len);
+        }
+    }
+
+    secure_memzero(s_prime, sizeof(s_prime));
+    return 0;
+}
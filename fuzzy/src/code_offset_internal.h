@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+#ifndef FUZZY_CODE_OFFSET_INTERNAL_H
+#define FUZZY_CODE_OFFSET_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* SYS_N and byte size for error vectors (from params.h: 3488) */
+#define SYS_N_BITS 3488
+#define SYS_N_BYTES (SYS_N_BITS / 8)
+
+/* Constants matching pqclean params.h */
+#define SYS_T 64
+#define GFBITS 12
+#define PK_NROWS (SYS_T * GFBITS)
+#define PK_NCOLS (SYS_N_BITS - PK_NROWS)
+#define PK_ROW_BYTES ((PK_NCOLS + 7) / 8)
+#define SYND_BYTES ((PK_NROWS + 7) / 8)
+
+/* PQClean KEM secret key contains Niederreiter secret key starting at +40. */
+#define SK_NIEDERREITER_OFFSET 40
+
+/* The helpers below are shared between modules of the umbrella compile unit
+ * (fuzzy_extractor.c) and are not exported from the library.
+ */
+
+/* s = H e for a caller-provided error vector e (PQClean encrypt.c syndrome). */
+static void code_offset_compute_syndrome(unsigned char *s, const unsigned char *pk, const unsigned char *e);
+
+/* Map a template w into an error vector: truncate or zero-pad to SYS_N_BYTES. */
+static void code_offset_load_template(unsigned char *e, const uint8_t *w, size_t wlen);
+
+/* Code-offset core on an already-mapped error vector (SYS_N_BYTES).
+ * Both functions wipe the vector they are given before returning, so
+ * front-ends can fill a stack buffer in place and hand it over.
+ */
+static int code_offset_encode_evec(unsigned char *e_vec,
+                                   uint8_t *helper_out,
+                                   uint8_t *public_key_out, uint8_t *secret_key_out,
+                                   uint8_t *key_out, size_t key_len);
+
+/* Enrollment against an existing public key (no keypair generation). */
+static int code_offset_encode_evec_pk(unsigned char *e_vec,
+                                      uint8_t *helper_out, const uint8_t *public_key,
+                                      uint8_t *key_out, size_t key_len);
+
+static int code_offset_decode_evec(unsigned char *e_prime,
+                                   const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                                   uint8_t *key_out, size_t key_len);
+
+/* Steps 3-5 of decode: e := e' XOR Goppa-decode(helper XOR s'), in place.
+ * Wipes e on failure; on success the caller owns (and must wipe) e.
+ */
+static int code_offset_recover_evec(unsigned char *e, const unsigned char *s_prime,
+                                    const uint8_t *helper, const uint8_t *secret_key);
+
+/* Steps 3-6 of decode given s' = H e' (Goppa decode + key derivation).
+ * Wipes e_prime.
+ */
+static int code_offset_decode_syndrome(unsigned char *e_prime, const unsigned char *s_prime,
+                                       const uint8_t *helper, const uint8_t *secret_key,
+                                       uint8_t *key_out, size_t key_len);
+
+#endif
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+
+#include "../fuzzy_extractor.h"
+#include "code_offset_internal.h"
+
+#include <string.h>
+#include <stdint.h>
+
+/* --- Streaming decode: fold each chunk of w' into s' = H e' as it lands --- */
+
+/* H = [I_PK_NROWS | T] with T = pk (PK_NROWS rows of PK_ROW_BYTES). Byte b of
+ * e' therefore contributes
+ *   b <  SYND_BYTES: its bits directly to the same bits of s' (identity), and
+ *   b >= SYND_BYTES: to every row i through column byte (b - SYND_BYTES) of T.
+ * Since H e' is linear, summing per-chunk contributions in any split gives
+ * the same s' as the one-shot code_offset_compute_syndrome().
+ */
+static void stream_fold_pk_columns(unsigned char *s, const unsigned char *pk,
+                                   const unsigned char *e_cols, size_t col_off, size_t len) {
+    const unsigned char *pk_ptr = pk + col_off;
+
+    for (int i = 0; i < PK_NROWS; i++) {
+        uint64_t acc = 0;
+        size_t j = 0;
+        for (; j + 8 <= len; j += 8) {
+            uint64_t a, b;
+            memcpy(&a, pk_ptr + j, 8);
+            memcpy(&b, e_cols + j, 8);
+            acc ^= a & b;
+        }
+        for (; j < len; j++) {
+            acc ^= (uint64_t)(pk_ptr[j] & e_cols[j]);
+        }
+
+        acc ^= acc >> 32;
+        acc ^= acc >> 16;
+        acc ^= acc >> 8;
+        acc ^= acc >> 4;
+        acc ^= acc >> 2;
+        acc ^= acc >> 1;
+
+        s[i / 8] ^= (unsigned char)((acc & 1u) << (i % 8));
+        pk_ptr += PK_ROW_BYTES;
+    }
+}
+
+int code_offset_decode_init(code_offset_decode_ctx *ctx,
+                            const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key) {
+    if (ctx == NULL || helper == NULL || public_key == NULL || secret_key == NULL) return -1;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->helper = helper;
+    ctx->public_key = public_key;
+    ctx->secret_key = secret_key;
+    return 0;
+}
+
+int code_offset_decode_update(code_offset_decode_ctx *ctx, const uint8_t *chunk, size_t len) {
+    if (ctx == NULL || ctx->public_key == NULL) return -1;
+    if (chunk == NULL && len > 0) return -1;
+
+    /* Like code_offset_decode(), anything past SYS_N_BYTES is ignored. */
+    size_t off = ctx->received;
+    if (off >= SYS_N_BYTES) return 0;
+    if (len > SYS_N_BYTES - off) len = SYS_N_BYTES - off;
+    if (len == 0) return 0;
+
+    memcpy(ctx->e_prime + off, chunk, len);
+    ctx->received = off + len;
+
+    const unsigned char *e = ctx->e_prime + off;
+
+    /* Identity part. */
+    while (off < SYND_BYTES && len > 0) {
+        ctx->s_prime[off] ^= *e;
+        off++;
+        e++;
+        len--;
+    }
+
+    /* pk column part. */
+    if (len > 0) {
+        stream_fold_pk_columns(ctx->s_prime, ctx->public_key, e, off - SYND_BYTES, len);
+    }
+    return 0;
+}
+
+int code_offset_decode_final(code_offset_decode_ctx *ctx, uint8_t *key_out, size_t key_len) {
+    if (ctx == NULL || ctx->public_key == NULL) return -1;
+    if (key_out == NULL || key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) {
+        secure_memzero(ctx, sizeof(*ctx));
+        return -1;
+    }
+
+    /* Bytes never received stay zero (zero-padded w'), contributing nothing. */
+    int rc = code_offset_decode_syndrome(ctx->e_prime, ctx->s_prime, ctx->helper, ctx->secret_key,
+                                         key_out, key_len);
+    secure_memzero(ctx, sizeof(*ctx));
+    return rc;
+}
@@ -0,0 +1,561 @@
+// SPDX-License-Identifier: MIT
+
+#include "../fuzzy_extractor.h"
+#include "code_offset_internal.h"
+
+#include <oqs/sha3.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+/* --- NUMA placement: topology, node-local memory, key replicas, worker pool --- */
+
+/* Linux support uses sysfs and raw syscalls (mbind, get_mempolicy, getcpu,
+ * sched_setaffinity) so no libnuma or _GNU_SOURCE is needed. Windows uses
+ * the Win32 NUMA API. Elsewhere the machine is treated as a single node.
+ */
+#define NUMA_MAX_NODES 64
+#define NUMA_MAX_CPUS 1024
+#define NUMA_MASK_WORDS (NUMA_MAX_CPUS / (8 * sizeof(unsigned long)))
+#define NUMA_WORD_BITS (8 * sizeof(unsigned long))
+
+typedef struct {
+    int nnodes;
+    int has_cpus[NUMA_MAX_NODES];
+    unsigned long cpumask[NUMA_MAX_NODES][NUMA_MASK_WORDS];
+} numa_topology_t;
+
+static numa_topology_t g_numa;
+
+#if defined(__linux__)
+/* Parse a sysfs cpulist ("0-3,8,10-11") into a mask. */
+static int numa_parse_cpulist(const char *s, unsigned long *mask) {
+    int any = 0;
+    while (*s != '\0' && *s != '\n') {
+        char *end;
+        long lo = strtol(s, &end, 10);
+        if (end == s) break;
+        long hi = lo;
+        s = end;
+        if (*s == '-') {
+            hi = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long c = lo; c <= hi && c < NUMA_MAX_CPUS; c++) {
+            if (c < 0) continue;
+            mask[c / NUMA_WORD_BITS] |= 1UL << (c % NUMA_WORD_BITS);
+            any = 1;
+        }
+        if (*s == ',') s++;
+    }
+    return any;
+}
+#endif
+
+static void numa_detect(void) {
+    memset(&g_numa, 0, sizeof(g_numa));
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest) && highest < NUMA_MAX_NODES) {
+        g_numa.nnodes = (int)highest + 1;
+        for (int n = 0; n < g_numa.nnodes; n++) {
+            GROUP_AFFINITY ga;
+            if (GetNumaNodeProcessorMaskEx((USHORT)n, &ga) && ga.Mask != 0) g_numa.has_cpus[n] = 1;
+        }
+    }
+#elif defined(__linux__)
+    for (int n = 0; n < NUMA_MAX_NODES; n++) {
+        char path[96];
+        char buf[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        FILE *f = fopen(path, "r");
+        if (f == NULL) continue;
+        if (fgets(buf, sizeof(buf), f) != NULL && numa_parse_cpulist(buf, g_numa.cpumask[n])) {
+            g_numa.has_cpus[n] = 1;
+        }
+        fclose(f);
+        g_numa.nnodes = n + 1;
+    }
+#endif
+    if (g_numa.nnodes == 0) {
+        g_numa.nnodes = 1;
+        g_numa.has_cpus[0] = 1;
+#if defined(__linux__)
+        if (syscall(SYS_sched_getaffinity, 0, sizeof(g_numa.cpumask[0]), g_numa.cpumask[0]) < 0) {
+            memset(g_numa.cpumask[0], 0xFF, sizeof(g_numa.cpumask[0]));
+        }
+#endif
+    }
+}
+
+#ifdef _WIN32
+static INIT_ONCE g_numa_once = INIT_ONCE_STATIC_INIT;
+static BOOL CALLBACK numa_detect_once(PINIT_ONCE once, PVOID param, PVOID *ctx) {
+    (void)once; (void)param; (void)ctx;
+    numa_detect();
+    return TRUE;
+}
+static void numa_init(void) {
+    InitOnceExecuteOnce(&g_numa_once, numa_detect_once, NULL, NULL);
+}
+#else
+static pthread_once_t g_numa_once = PTHREAD_ONCE_INIT;
+static void numa_init(void) {
+    pthread_once(&g_numa_once, numa_detect);
+}
+#endif
+
+int fuzzy_numa_node_count(void) {
+    numa_init();
+    return g_numa.nnodes;
+}
+
+int fuzzy_numa_current_node(void) {
+    numa_init();
+#if defined(_WIN32)
+    PROCESSOR_NUMBER pn;
+    USHORT node = 0;
+    GetCurrentProcessorNumberEx(&pn);
+    if (!GetNumaProcessorNodeEx(&pn, &node)) return 0;
+    return (int)node;
+#elif defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) return 0;
+    return ((int)node < g_numa.nnodes) ? (int)node : 0;
+#else
+    return 0;
+#endif
+}
+
+int fuzzy_numa_node_of(const void *addr) {
+    if (addr == NULL) return -1;
+    numa_init();
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    int node = -1;
+    /* MPOL_F_NODE | MPOL_F_ADDR: node of the page backing addr. */
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0UL, addr, 1UL | 2UL) != 0) return -1;
+    return node;
+#else
+    return (g_numa.nnodes == 1) ? 0 : -1;
+#endif
+}
+
+int fuzzy_numa_bind_thread(int node) {
+    numa_init();
+    if (node < 0 || node >= g_numa.nnodes || !g_numa.has_cpus[node]) return -1;
+#if defined(_WIN32)
+    GROUP_AFFINITY ga;
+    if (!GetNumaNodeProcessorMaskEx((USHORT)node, &ga)) return -1;
+    return SetThreadGroupAffinity(GetCurrentThread(), &ga, NULL) ? 0 : -1;
+#elif defined(__linux__)
+    /* pid 0 = calling thread. */
+    return (syscall(SYS_sched_setaffinity, 0, sizeof(g_numa.cpumask[node]), g_numa.cpumask[node]) == 0) ? 0 : -1;
+#else
+    return 0;
+#endif
+}
+
+static size_t numa_round_pages(size_t len) {
+    return (len + 4095) / 4096 * 4096;
+}
+
+void *fuzzy_numa_alloc(size_t len, int node) {
+    numa_init();
+    if (len == 0) return NULL;
+    if (node < 0) node = fuzzy_numa_current_node();
+    if (node >= g_numa.nnodes) node = 0;
+    size_t map_len = numa_round_pages(len);
+
+#if defined(_WIN32)
+    void *p = VirtualAllocExNuma(GetCurrentProcess(), NULL, map_len, MEM_RESERVE | MEM_COMMIT,
+                                 PAGE_READWRITE, (DWORD)node);
+    if (p == NULL) return NULL;
+    /* Committed pages are only backed on first touch; fault them in now. */
+    memset(p, 0, map_len);
+    return p;
+#else
+    void *p = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+#if defined(__linux__) && defined(SYS_mbind)
+    if (g_numa.nnodes > 1) {
+        unsigned long nodemask[NUMA_MAX_NODES / NUMA_WORD_BITS + 1];
+        memset(nodemask, 0, sizeof(nodemask));
+        nodemask[node / NUMA_WORD_BITS] |= 1UL << (node % NUMA_WORD_BITS);
+        /* MPOL_PREFERRED: fall back to other nodes rather than failing. */
+        (void)syscall(SYS_mbind, p, map_len, 1, nodemask, (unsigned long)NUMA_MAX_NODES + 1, 0U);
+    }
+#endif
+    /* Fault the pages in now so placement does not depend on the first user. */
+    memset(p, 0, map_len);
+    return p;
+#endif
+}
+
+void fuzzy_numa_free(void *p, size_t len) {
+    if (p == NULL) return;
+    size_t map_len = numa_round_pages(len);
+    secure_memzero(p, map_len);
+#if defined(_WIN32)
+    (void)map_len;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, map_len);
+#endif
+}
+
+/* --- Per-node key replicas --- */
+
+#define REPLICA_LEN (MCELIECE_348864F_PUBLIC_KEY_LEN + MCELIECE_348864F_SECRET_KEY_LEN)
+
+struct fuzzy_key_replicas {
+    int nnodes;
+    uint8_t key_id[FUZZY_SYSTEM_KEY_ID_LEN];
+    unsigned char *copy[NUMA_MAX_NODES];
+};
+
+int fuzzy_key_replicas_create(fuzzy_key_replicas **out, const uint8_t *public_key, const uint8_t *secret_key) {
+    if (out == NULL || public_key == NULL || secret_key == NULL) return -1;
+    *out = NULL;
+
+    fuzzy_key_replicas *r = (fuzzy_key_replicas *)calloc(1, sizeof(fuzzy_key_replicas));
+    if (r == NULL) return -1;
+    r->nnodes = fuzzy_numa_node_count();
+
+    for (int n = 0; n < r->nnodes; n++) {
+        r->copy[n] = (unsigned char *)fuzzy_numa_alloc(REPLICA_LEN, n);
+        if (r->copy[n] == NULL) {
+            fuzzy_key_replicas_release(r);
+            return -1;
+        }
+        memcpy(r->copy[n], public_key, MCELIECE_348864F_PUBLIC_KEY_LEN);
+        memcpy(r->copy[n] + MCELIECE_348864F_PUBLIC_KEY_LEN, secret_key, MCELIECE_348864F_SECRET_KEY_LEN);
+    }
+    /* Same derivation as fuzzy_system_key_id(), so the two compare directly. */
+    uint8_t digest[32];
+    OQS_SHA3_shake256(digest, sizeof(digest), public_key, MCELIECE_348864F_PUBLIC_KEY_LEN);
+    memcpy(r->key_id, digest, FUZZY_SYSTEM_KEY_ID_LEN);
+    *out = r;
+    return 0;
+}
+
+int fuzzy_key_replicas_id(const fuzzy_key_replicas *r, uint8_t *id_out) {
+    if (r == NULL || id_out == NULL) return -1;
+    memcpy(id_out, r->key_id, FUZZY_SYSTEM_KEY_ID_LEN);
+    return 0;
+}
+
+void fuzzy_key_replicas_release(fuzzy_key_replicas *r) {
+    if (r == NULL) return;
+    for (int n = 0; n < r->nnodes; n++) fuzzy_numa_free(r->copy[n], REPLICA_LEN);
+    free(r);
+}
+
+size_t fuzzy_key_replicas_footprint(const fuzzy_key_replicas *r, size_t *heap_out) {
+    if (heap_out != NULL) *heap_out = (r == NULL) ? 0 : sizeof(*r);
+    return (r == NULL) ? 0 : (size_t)r->nnodes * numa_round_pages(REPLICA_LEN);
+}
+
+static const unsigned char *replica_for(const fuzzy_key_replicas *r, int node) {
+    if (node < 0) node = fuzzy_numa_current_node();
+    if (node >= r->nnodes) node = 0;
+    return r->copy[node];
+}
+
+const uint8_t *fuzzy_key_replicas_public_key(const fuzzy_key_replicas *r, int node) {
+    if (r == NULL) return NULL;
+    return replica_for(r, node);
+}
+
+const uint8_t *fuzzy_key_replicas_secret_key(const fuzzy_key_replicas *r, int node) {
+    if (r == NULL) return NULL;
+    return replica_for(r, node) + MCELIECE_348864F_PUBLIC_KEY_LEN;
+}
+
+int code_offset_decode_replicated(const fuzzy_key_replicas *r,
+                                  const uint8_t *wprime, size_t wlen,
+                                  const uint8_t *helper,
+                                  uint8_t *key_out, size_t key_len) {
+    if (r == NULL) return -1;
+    const unsigned char *k = replica_for(r, -1);
+    return code_offset_decode(wprime, wlen, helper, k, k + MCELIECE_348864F_PUBLIC_KEY_LEN, key_out, key_len);
+}
+
+/* --- Node-pinned worker pool --- */
+
+#ifdef _WIN32
+typedef SRWLOCK numa_mutex_t;
+typedef CONDITION_VARIABLE numa_cond_t;
+typedef HANDLE numa_thread_t;
+#define numa_mutex_init(m) InitializeSRWLock(m)
+#define numa_mutex_destroy(m) ((void)(m))
+#define numa_mutex_lock(m) AcquireSRWLockExclusive(m)
+#define numa_mutex_unlock(m) ReleaseSRWLockExclusive(m)
+#define numa_cond_init(c) InitializeConditionVariable(c)
+#define numa_cond_destroy(c) ((void)(c))
+#define numa_cond_wait(c, m) SleepConditionVariableSRW((c), (m), INFINITE, 0)
+#define numa_cond_signal(c) WakeConditionVariable(c)
+#define numa_cond_broadcast(c) WakeAllConditionVariable(c)
+#else
+typedef pthread_mutex_t numa_mutex_t;
+typedef pthread_cond_t numa_cond_t;
+typedef pthread_t numa_thread_t;
+#define numa_mutex_init(m) pthread_mutex_init((m), NULL)
+#define numa_mutex_destroy(m) pthread_mutex_destroy(m)
+#define numa_mutex_lock(m) pthread_mutex_lock(m)
+#define numa_mutex_unlock(m) pthread_mutex_unlock(m)
+#define numa_cond_init(c) pthread_cond_init((c), NULL)
+#define numa_cond_destroy(c) pthread_cond_destroy(c)
+#define numa_cond_wait(c, m) pthread_cond_wait((c), (m))
+#define numa_cond_signal(c) pthread_cond_signal(c)
+#define numa_cond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+
+typedef struct {
+    fuzzy_numa_task_fn fn;
+    void *arg;
+} numa_task_t;
+
+/* Bounded FIFO per node; `pending` counts queued + running tasks. */
+typedef struct {
+    numa_mutex_t lock;
+    numa_cond_t not_empty;
+    numa_cond_t not_full;
+    numa_cond_t idle;
+    numa_task_t *ring;
+    size_t cap;
+    size_t head;
+    size_t count;
+    size_t pending;
+    int stop;
+} numa_queue_t;
+
+typedef struct {
+    fuzzy_numa_pool *pool;
+    int node;
+    void *scratch;
+    numa_thread_t thread;
+    int started;
+} numa_worker_t;
+
+struct fuzzy_numa_pool {
+    int nnodes;
+    size_t scratch_len;
+    numa_queue_t queues[NUMA_MAX_NODES];
+    numa_worker_t *workers;
+    size_t nworkers;
+    unsigned rr;
+};
+
+static void numa_worker_run(numa_worker_t *wk) {
+    fuzzy_numa_pool *pool = wk->pool;
+    numa_queue_t *q = &pool->queues[wk->node];
+
+    (void)fuzzy_numa_bind_thread(wk->node);
+
+    for (;;) {
+        numa_mutex_lock(&q->lock);
+        while (q->count == 0 && !q->stop) numa_cond_wait(&q->not_empty, &q->lock);
+        if (q->count == 0) {
+            numa_mutex_unlock(&q->lock);
+            break;
+        }
+        numa_task_t t = q->ring[q->head];
+        q->head = (q->head + 1) % q->cap;
+        q->count--;
+        numa_cond_signal(&q->not_full);
+        numa_mutex_unlock(&q->lock);
+
+        t.fn(t.arg, wk->node, wk->scratch, pool->scratch_len);
+
+        numa_mutex_lock(&q->lock);
+        if (--q->pending == 0) numa_cond_broadcast(&q->idle);
+        numa_mutex_unlock(&q->lock);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI numa_worker_main(LPVOID arg) {
+    numa_worker_run((numa_worker_t *)arg);
+    return 0;
+}
+static int numa_thread_start(numa_worker_t *wk) {
+    wk->thread = CreateThread(NULL, 0, numa_worker_main, wk, 0, NULL);
+    return (wk->thread == NULL) ? -1 : 0;
+}
+static void numa_thread_join(numa_worker_t *wk) {
+    WaitForSingleObject(wk->thread, INFINITE);
+    CloseHandle(wk->thread);
+}
+#else
+static void *numa_worker_main(void *arg) {
+    numa_worker_run((numa_worker_t *)arg);
+    return NULL;
+}
+static int numa_thread_start(numa_worker_t *wk) {
+    return pthread_create(&wk->thread, NULL, numa_worker_main, wk);
+}
+static void numa_thread_join(numa_worker_t *wk) {
+    pthread_join(wk->thread, NULL);
+}
+#endif
+
+int fuzzy_numa_pool_create(fuzzy_numa_pool **out, int threads_per_node,
+                           size_t queue_depth, size_t scratch_len) {
+    if (out == NULL || threads_per_node <= 0 || queue_depth == 0) return -1;
+    *out = NULL;
+
+    fuzzy_numa_pool *pool = (fuzzy_numa_pool *)calloc(1, sizeof(fuzzy_numa_pool));
+    if (pool == NULL) return -1;
+    pool->nnodes = fuzzy_numa_node_count();
+    pool->scratch_len = scratch_len;
+
+    int nodes_with_cpus = 0;
+    for (int n = 0; n < pool->nnodes; n++) {
+        numa_queue_t *q = &pool->queues[n];
+        /* destroy() tears down exactly the queues that have a ring, so the
+         * ring comes first and the locks only once it exists. */
+        q->ring = (numa_task_t *)calloc(queue_depth, sizeof(numa_task_t));
+        if (q->ring == NULL) {
+            fuzzy_numa_pool_destroy(pool);
+            return -1;
+        }
+        q->cap = queue_depth;
+        numa_mutex_init(&q->lock);
+        numa_cond_init(&q->not_empty);
+        numa_cond_init(&q->not_full);
+        numa_cond_init(&q->idle);
+        nodes_with_cpus += g_numa.has_cpus[n];
+    }
+
+    pool->workers = (numa_worker_t *)calloc((size_t)nodes_with_cpus * (size_t)threads_per_node, sizeof(numa_worker_t));
+    if (pool->workers == NULL) {
+        fuzzy_numa_pool_destroy(pool);
+        return -1;
+    }
+    for (int n = 0; n < pool->nnodes; n++) {
+        if (!g_numa.has_cpus[n]) continue;
+        for (int t = 0; t < threads_per_node; t++) {
+            numa_worker_t *wk = &pool->workers[pool->nworkers];
+            wk->pool = pool;
+            wk->node = n;
+            /* Every task gets the arena it was promised, so a worker is only
+             * started once its arena exists. */
+            if (scratch_len != 0) {
+                wk->scratch = fuzzy_numa_alloc(scratch_len, n);
+                if (wk->scratch == NULL) {
+                    fuzzy_numa_pool_destroy(pool);
+                    return -1;
+                }
+            }
+            if (numa_thread_start(wk) != 0) {
+                fuzzy_numa_free(wk->scratch, scratch_len);
+                fuzzy_numa_pool_destroy(pool);
+                return -1;
+            }
+            wk->started = 1;
+            pool->nworkers++;
+        }
+    }
+    *out = pool;
+    return 0;
+}
+
+/* Memory-only nodes have no workers; route their work to the next node that has CPUs. */
+static int numa_route(const fuzzy_numa_pool *pool, int node) {
+    for (int i = 0; i < pool->nnodes; i++) {
+        int n = (node + i) % pool->nnodes;
+        if (g_numa.has_cpus[n]) return n;
+    }
+    return 0;
+}
+
+int fuzzy_numa_pool_submit(fuzzy_numa_pool *pool, int node, fuzzy_numa_task_fn fn, void *arg) {
+    if (pool == NULL || fn == NULL) return -1;
+    if (node < 0 || node >= pool->nnodes) {
+        node = (int)(__atomic_fetch_add(&pool->rr, 1u, __ATOMIC_RELAXED) % (unsigned)pool->nnodes);
+    }
+    node = numa_route(pool, node);
+    numa_queue_t *q = &pool->queues[node];
+
+    numa_mutex_lock(&q->lock);
+    while (q->count == q->cap && !q->stop) numa_cond_wait(&q->not_full, &q->lock);
+    if (q->stop) {
+        numa_mutex_unlock(&q->lock);
+        return -1;
+    }
+    q->ring[(q->head + q->count) % q->cap] = (numa_task_t){ fn, arg };
+    q->count++;
+    q->pending++;
+    numa_cond_signal(&q->not_empty);
+    numa_mutex_unlock(&q->lock);
+    return node;
+}
+
+int fuzzy_numa_pool_submit_near(fuzzy_numa_pool *pool, const void *data, fuzzy_numa_task_fn fn, void *arg) {
+    return fuzzy_numa_pool_submit(pool, fuzzy_numa_node_of(data), fn, arg);
+}
+
+void fuzzy_numa_pool_wait(fuzzy_numa_pool *pool) {
+    if (pool == NULL) return;
+    for (int n = 0; n < pool->nnodes; n++) {
+        numa_queue_t *q = &pool->queues[n];
+        if (q->ring == NULL) continue;
+        numa_mutex_lock(&q->lock);
+        while (q->pending != 0) numa_cond_wait(&q->idle, &q->lock);
+        numa_mutex_unlock(&q->lock);
+    }
+}
+
+size_t fuzzy_numa_pool_footprint(const fuzzy_numa_pool *pool, size_t *heap_out) {
+    if (pool == NULL) {
+        if (heap_out != NULL) *heap_out = 0;
+        return 0;
+    }
+    size_t heap = sizeof(*pool) + pool->nworkers * sizeof(numa_worker_t);
+    for (int n = 0; n < pool->nnodes; n++) {
+        if (pool->queues[n].ring != NULL) heap += pool->queues[n].cap * sizeof(numa_task_t);
+    }
+    if (heap_out != NULL) *heap_out = heap;
+    return pool->scratch_len ? pool->nworkers * numa_round_pages(pool->scratch_len) : 0;
+}
+
+void fuzzy_numa_pool_destroy(fuzzy_numa_pool *pool) {
+    if (pool == NULL) return;
+    for (int n = 0; n < pool->nnodes; n++) {
+        numa_queue_t *q = &pool->queues[n];
+        if (q->ring == NULL) continue;
+        numa_mutex_lock(&q->lock);
+        q->stop = 1;
+        numa_cond_broadcast(&q->not_empty);
+        numa_cond_broadcast(&q->not_full);
+        numa_mutex_unlock(&q->lock);
+    }
+    for (size_t i = 0; i < pool->nworkers; i++) {
+        if (pool->workers[i].started) numa_thread_join(&pool->workers[i]);
+        fuzzy_numa_free(pool->workers[i].scratch, pool->scratch_len);
+    }
+    for (int n = 0; n < pool->nnodes; n++) {
+        numa_queue_t *q = &pool->queues[n];
+        if (q->ring == NULL) continue;
+        numa_cond_destroy(&q->not_empty);
+        numa_cond_destroy(&q->not_full);
+        numa_cond_destroy(&q->idle);
+        numa_mutex_destroy(&q->lock);
+        free(q->ring);
+    }
+    free(pool->workers);
+    free(pool);
+}
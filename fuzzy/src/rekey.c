@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+
+#include "../fuzzy_extractor.h"
+#include "code_offset_internal.h"
+
+#include <string.h>
+#include <stdint.h>
+
+/* --- Re-keying: move an enrollment from one McEliece key pair to another --- */
+
+/* A successful decode under the old key pair recovers the enrolled e itself,
+ * not only its hash. Syndromes of e under the new public key are a valid
+ * helper for the same e, so the derived key is unchanged and the user never
+ * has to re-enroll. e only lives in the local buffer and is wiped on every
+ * path (code_offset_encode_evec_pk() wipes it on success).
+ */
+static int rekey_recover(unsigned char *e,
+                         const uint8_t *wprime, size_t wlen,
+                         const uint8_t *old_helper, const uint8_t *old_public_key,
+                         const uint8_t *old_secret_key) {
+    unsigned char s_prime[SYND_BYTES];
+
+    code_offset_load_template(e, wprime, wlen);
+    code_offset_compute_syndrome(s_prime, old_public_key, e);
+    int rc = code_offset_recover_evec(e, s_prime, old_helper, old_secret_key);
+
+    secure_memzero(s_prime, sizeof(s_prime));
+    return rc;
+}
+
+int code_offset_rekey(const uint8_t *wprime, size_t wlen,
+                      const uint8_t *old_helper, const uint8_t *old_public_key, const uint8_t *old_secret_key,
+                      const uint8_t *new_public_key,
+                      uint8_t *new_helper_out,
+                      uint8_t *key_out, size_t key_len) {
+    if (old_helper == NULL || old_public_key == NULL || old_secret_key == NULL) return -1;
+    if (new_public_key == NULL || new_helper_out == NULL) return -1;
+    if (key_out != NULL && (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN)) return -1;
+
+    unsigned char e[SYS_N_BYTES];
+    int rc = rekey_recover(e, wprime, wlen, old_helper, old_public_key, old_secret_key);
+    if (rc != 0) return rc;
+
+    uint8_t key[MCELIECE_348864F_SHARED_SECRET_LEN];
+    rc = code_offset_encode_evec_pk(e, new_helper_out, new_public_key, key, sizeof(key));
+    if (rc == 0 && key_out != NULL) memcpy(key_out, key, key_len);
+
+    secure_memzero(key, sizeof(key));
+    secure_memzero(e, sizeof(e));
+    return rc;
+}
+
+int code_offset_rekey_keygen(const uint8_t *wprime, size_t wlen,
+                             const uint8_t *old_helper, const uint8_t *old_public_key, const uint8_t *old_secret_key,
+                             uint8_t *new_helper_out,
+                             uint8_t *new_public_key_out, uint8_t *new_secret_key_out,
+                             uint8_t *key_out, size_t key_len) {
+    if (new_public_key_out == NULL || new_secret_key_out == NULL) return -1;
+    if (old_helper == NULL || old_public_key == NULL || old_secret_key == NULL || new_helper_out == NULL) return -1;
+    if (key_out != NULL && (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN)) return -1;
+
+    /* Recover first: a failed sample must not cost a key generation. */
+    unsigned char e[SYS_N_BYTES];
+    int rc = rekey_recover(e, wprime, wlen, old_helper, old_public_key, old_secret_key);
+    if (rc != 0) return rc;
+
+    uint8_t key[MCELIECE_348864F_SHARED_SECRET_LEN];
+    rc = code_offset_encode_evec(e, new_helper_out, new_public_key_out, new_secret_key_out, key, sizeof(key));
+    if (rc == 0 && key_out != NULL) memcpy(key_out, key, key_len);
+
+    secure_memzero(key, sizeof(key));
+    secure_memzero(e, sizeof(e));
+    return rc;
+}
+
+int code_offset_rekey_shared(const uint8_t *wprime, size_t wlen,
+                             const uint8_t *old_helper, const uint8_t *old_public_key, const uint8_t *old_secret_key,
+                             const fuzzy_system_key *sys,
+                             uint8_t *new_helper_out,
+                             uint8_t *key_out, size_t key_len) {
+    const unsigned char *base = (sys == NULL) ? NULL : syskey_base(sys);
+    if (base == NULL) return -1;
+    return code_offset_rekey(wprime, wlen, old_helper, old_public_key, old_secret_key,
+                             base + SYSKEY_PK_OFFSET, new_helper_out, key_out, key_len);
+}
+
+/* Across a system-key rotation: old_sys is usually the retired generation,
+ * which keeps its secret key until fuzzy_system_key_release_retired(). */
+int code_offset_rekey_system(const uint8_t *wprime, size_t wlen,
+                             const uint8_t *old_helper, const fuzzy_system_key *old_sys,
+                             const fuzzy_system_key *new_sys,
+                             uint8_t *new_helper_out,
+                             uint8_t *key_out, size_t key_len) {
+    const unsigned char *old_base = (old_sys == NULL) ? NULL : syskey_base(old_sys);
+    const unsigned char *new_base = (new_sys == NULL) ? NULL : syskey_base(new_sys);
+    if (old_base == NULL || new_base == NULL) return -1;
+    return code_offset_rekey(wprime, wlen, old_helper,
+                             old_base + SYSKEY_PK_OFFSET, old_base + SYSKEY_SK_OFFSET,
+                             new_base + SYSKEY_PK_OFFSET, new_helper_out, key_out, key_len);
+}
@@ -0,0 +1,588 @@
+// SPDX-License-Identifier: MIT
+
+#include "../fuzzy_extractor.h"
+#include "oqs_pqclean_decls.h"
+#include "code_offset_internal.h"
+
+#include <oqs/sha3.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+/* --- Shared system key: one tenant-wide McEliece keypair in shared memory --- */
+
+/* Segment layout (page aligned, mapped read-only by attachers):
+ *   [0, 4096)               syskey_header_t
+ *   [4096, +PK_LEN)         public key
+ *   [.., +SK_LEN)           KEM secret key
+ * Named segments use POSIX shm_open; unnamed ones use a Linux memfd
+ * (MFD_HUGETLB when huge pages are reserved) whose fd can be inherited or
+ * passed over a socket. The header lives in the segment so that attachers
+ * see `retired` flip when the owner rotates.
+ *
+ * Rotation never touches the previous generation's contents: both owner and
+ * attacher handles keep it mapped as `retired` until
+ * fuzzy_system_key_release_retired(), so threads still decoding through the
+ * old mapping and helpers enrolled under the old key keep working.
+ */
+#define SYSKEY_MAGIC 0x59454B5359535A46ULL /* "FZSYSKEY" */
+#define SYSKEY_VERSION 1u
+#define SYSKEY_HEADER_LEN 4096
+#define SYSKEY_PK_OFFSET SYSKEY_HEADER_LEN
+#define SYSKEY_SK_OFFSET (SYSKEY_PK_OFFSET + MCELIECE_348864F_PUBLIC_KEY_LEN)
+#define SYSKEY_DATA_LEN (SYSKEY_SK_OFFSET + MCELIECE_348864F_SECRET_KEY_LEN)
+#define SYSKEY_HUGE_PAGE (2u * 1024u * 1024u)
+#define SYSKEY_NAME_MAX 240
+#define SYSKEY_NAME_SUFFIX_MAX 24 /* ".g" + 20 digits + NUL, rounded */
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t retired;
+    uint64_t generation;
+    uint64_t seg_len;
+    uint8_t key_id[FUZZY_SYSTEM_KEY_ID_LEN];
+} syskey_header_t;
+
+struct fuzzy_system_key {
+    unsigned char *base;
+    size_t map_len;
+    int fd;
+    int owner;
+    int huge;
+    fuzzy_system_key *retired;   /* previous generation, until release_retired */
+    char name[SYSKEY_NAME_MAX + 2 + SYSKEY_NAME_SUFFIX_MAX];
+};
+
+/* `base` is swapped by rotate/refresh while other threads may be decoding
+ * through the same handle; readers load it once per call. */
+static const unsigned char *syskey_base(const fuzzy_system_key *sys) {
+    return __atomic_load_n(&sys->base, __ATOMIC_ACQUIRE);
+}
+
+static const syskey_header_t *syskey_header(const fuzzy_system_key *sys) {
+    return (const syskey_header_t *)syskey_base(sys);
+}
+
+static int syskey_is_valid(const unsigned char *base, size_t map_len) {
+    const syskey_header_t *h = (const syskey_header_t *)base;
+    return map_len >= SYSKEY_DATA_LEN && h->magic == SYSKEY_MAGIC &&
+           h->version == SYSKEY_VERSION && h->seg_len <= map_len;
+}
+
+/* Generate the keypair in place and fill in the header. */
+static int syskey_populate(unsigned char *base, size_t seg_len, uint64_t generation) {
+    syskey_header_t *h = (syskey_header_t *)base;
+    unsigned char *pk = base + SYSKEY_PK_OFFSET;
+    unsigned char *sk = base + SYSKEY_SK_OFFSET;
+
+    int rc = PQCLEAN_MCELIECE348864F_CLEAN_crypto_kem_keypair(pk, sk);
+    if (rc != 0) {
+        secure_memzero(sk, MCELIECE_348864F_SECRET_KEY_LEN);
+        return rc;
+    }
+
+    uint8_t digest[32];
+    OQS_SHA3_shake256(digest, sizeof(digest), pk, MCELIECE_348864F_PUBLIC_KEY_LEN);
+    memcpy(h->key_id, digest, FUZZY_SYSTEM_KEY_ID_LEN);
+    h->generation = generation;
+    h->seg_len = seg_len;
+    h->retired = 0;
+    h->version = SYSKEY_VERSION;
+    h->magic = SYSKEY_MAGIC;
+    return 0;
+}
+
+#ifdef _WIN32
+
+/* Windows: process-local segment only (VirtualAlloc, large pages when the
+ * process holds SeLockMemoryPrivilege). Named/cross-process segments are
+ * not supported on this platform.
+ */
+static int syskey_map_new(fuzzy_system_key *sys, const char *name) {
+    if (name != NULL) return -1;
+
+    SIZE_T large = GetLargePageMinimum();
+    if (large > 0) {
+        size_t len = (SYSKEY_DATA_LEN + large - 1) / large * large;
+        void *p = VirtualAlloc(NULL, len, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (p != NULL) {
+            sys->base = (unsigned char *)p;
+            sys->map_len = len;
+            sys->huge = 1;
+            return 0;
+        }
+    }
+    size_t len = (SYSKEY_DATA_LEN + 4095) / 4096 * 4096;
+    void *p = VirtualAlloc(NULL, len, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (p == NULL) return -1;
+    sys->base = (unsigned char *)p;
+    sys->map_len = len;
+    return 0;
+}
+
+static void syskey_protect(fuzzy_system_key *sys, int writable) {
+    DWORD old;
+    if (sys->huge) return; /* large pages cannot change protection */
+    VirtualProtect(sys->base, sys->map_len, writable ? PAGE_READWRITE : PAGE_READONLY, &old);
+}
+
+static void syskey_unmap(fuzzy_system_key *sys, int destroy) {
+    if (sys->base == NULL) return;
+    if (destroy) {
+        syskey_protect(sys, 1);
+        secure_memzero(sys->base + SYSKEY_SK_OFFSET, MCELIECE_348864F_SECRET_KEY_LEN);
+    }
+    VirtualFree(sys->base, 0, MEM_RELEASE);
+    sys->base = NULL;
+}
+
+static int syskey_map_existing(fuzzy_system_key *sys, const char *name, int fd) {
+    (void)sys; (void)name; (void)fd;
+    return -1;
+}
+
+#else
+
+static void syskey_hint_huge(unsigned char *base, size_t len) {
+#if defined(MADV_HUGEPAGE)
+    (void)madvise(base, len, MADV_HUGEPAGE);
+#else
+    (void)base; (void)len;
+#endif
+}
+
+static int syskey_open_memfd(int huge) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    /* MFD_CLOEXEC = 1, MFD_HUGETLB = 4 (linux/memfd.h) */
+    unsigned int flags = 1u | (huge ? 4u : 0u);
+    return (int)syscall(SYS_memfd_create, "fuzzy-system-key", flags);
+#else
+    (void)huge;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static int syskey_map_fd(fuzzy_system_key *sys, int fd, size_t len, int prot) {
+    void *p = mmap(NULL, len, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return -1;
+    sys->base = (unsigned char *)p;
+    sys->map_len = len;
+    sys->fd = fd;
+    return 0;
+}
+
+static int syskey_map_new(fuzzy_system_key *sys, const char *name) {
+    size_t len = (SYSKEY_DATA_LEN + 4095) / 4096 * 4096;
+
+    if (name == NULL) {
+        /* Prefer a hugetlb memfd; it fails at ftruncate/mmap when no huge
+         * pages are reserved, in which case fall back to a regular memfd. */
+        size_t huge_len = (SYSKEY_DATA_LEN + SYSKEY_HUGE_PAGE - 1) / SYSKEY_HUGE_PAGE * SYSKEY_HUGE_PAGE;
+        int fd = syskey_open_memfd(1);
+        if (fd >= 0) {
+            if (ftruncate(fd, (off_t)huge_len) == 0 &&
+                syskey_map_fd(sys, fd, huge_len, PROT_READ | PROT_WRITE) == 0) {
+                sys->huge = 1;
+                return 0;
+            }
+            close(fd);
+        }
+        fd = syskey_open_memfd(0);
+        if (fd < 0) {
+            /* No memfd: process-local anonymous mapping. */
+            void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return -1;
+            sys->base = (unsigned char *)p;
+            sys->map_len = len;
+            syskey_hint_huge(sys->base, len);
+            return 0;
+        }
+        if (ftruncate(fd, (off_t)len) != 0 || syskey_map_fd(sys, fd, len, PROT_READ | PROT_WRITE) != 0) {
+            close(fd);
+            return -1;
+        }
+        syskey_hint_huge(sys->base, len);
+        return 0;
+    }
+
+    int fd = shm_open(sys->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, (off_t)len) != 0 || syskey_map_fd(sys, fd, len, PROT_READ | PROT_WRITE) != 0) {
+        close(fd);
+        shm_unlink(sys->name);
+        return -1;
+    }
+    syskey_hint_huge(sys->base, len);
+    return 0;
+}
+
+static int syskey_map_existing(fuzzy_system_key *sys, const char *name, int fd) {
+    int own_fd = -1;
+    if (name != NULL) {
+        own_fd = shm_open(sys->name, O_RDONLY, 0);
+        if (own_fd < 0) return -1;
+        fd = own_fd;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < SYSKEY_DATA_LEN ||
+        syskey_map_fd(sys, fd, (size_t)st.st_size, PROT_READ) != 0) {
+        if (own_fd >= 0) close(own_fd);
+        return -1;
+    }
+    if (!syskey_is_valid(sys->base, sys->map_len)) {
+        munmap(sys->base, sys->map_len);
+        sys->base = NULL;
+        if (own_fd >= 0) close(own_fd);
+        return -1;
+    }
+    /* Keep our own shm descriptor; a caller-provided fd stays theirs. */
+    sys->fd = own_fd;
+    return 0;
+}
+
+static void syskey_protect(fuzzy_system_key *sys, int writable) {
+    (void)mprotect(sys->base, sys->map_len, writable ? (PROT_READ | PROT_WRITE) : PROT_READ);
+}
+
+static void syskey_unmap(fuzzy_system_key *sys, int destroy) {
+    if (sys->base == NULL) return;
+    if (destroy) {
+        syskey_protect(sys, 1);
+        secure_memzero(sys->base + SYSKEY_SK_OFFSET, MCELIECE_348864F_SECRET_KEY_LEN);
+    }
+    munmap(sys->base, sys->map_len);
+    sys->base = NULL;
+    if (sys->fd >= 0) close(sys->fd);
+    sys->fd = -1;
+    if (destroy && sys->name[0] != '\0') shm_unlink(sys->name);
+}
+
+#if !defined(__linux__)
+/* Create `name` holding a copy of src; returns the read-write fd or -1. */
+static int syskey_shm_fill(const char *name, const unsigned char *src, size_t len) {
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) return -1;
+    size_t done = 0;
+    if (ftruncate(fd, (off_t)len) == 0) {
+        while (done < len) {
+            ssize_t n = pwrite(fd, src + done, len - done, (off_t)done);
+            if (n <= 0) break;
+            done += (size_t)n;
+        }
+    }
+    if (done != len) {
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+/* Move the populated successor `next`, built under a generation-suffixed
+ * name, onto `name`. On Linux shm objects are files in /dev/shm and a rename
+ * replaces the old object atomically, so attachers always find a generation.
+ * Elsewhere the name is re-created from a copy of the successor; should that
+ * fail, the bytes of `prev` are put back so the old generation stays
+ * attachable. On failure `next` is left under its suffixed name.
+ */
+static int syskey_publish(fuzzy_system_key *next, const char *name, const fuzzy_system_key *prev) {
+#if defined(__linux__)
+    (void)prev;
+    char from[sizeof("/dev/shm") + sizeof(next->name)];
+    char to[sizeof("/dev/shm") + sizeof(next->name)];
+    snprintf(from, sizeof(from), "/dev/shm%s", next->name);
+    snprintf(to, sizeof(to), "/dev/shm%s", name);
+    if (rename(from, to) != 0) return -1;
+#else
+    shm_unlink(name);
+    int fd = syskey_shm_fill(name, next->base, next->map_len);
+    fuzzy_system_key moved = *next;
+    moved.base = NULL;
+    if (fd < 0 || syskey_map_fd(&moved, fd, next->map_len, PROT_READ) != 0) {
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(name);
+        }
+        int back = syskey_shm_fill(name, prev->base, prev->map_len);
+        if (back >= 0) close(back);
+        return -1;
+    }
+    syskey_unmap(next, 1); /* wipes and unlinks the suffixed copy */
+    *next = moved;
+#endif
+    memcpy(next->name, name, strlen(name) + 1);
+    return 0;
+}
+
+#endif
+
+static int syskey_set_name(fuzzy_system_key *sys, const char *name) {
+    sys->name[0] = '\0';
+    if (name == NULL) return 0;
+    size_t n = strlen(name);
+    if (n == 0 || n > SYSKEY_NAME_MAX) return -1;
+    /* POSIX shm names start with a single '/'. */
+    size_t off = (name[0] == '/') ? 0 : 1;
+    sys->name[0] = '/';
+    memcpy(sys->name + off, name, n + 1);
+    return 0;
+}
+
+static fuzzy_system_key *syskey_alloc(void) {
+    fuzzy_system_key *sys = (fuzzy_system_key *)calloc(1, sizeof(fuzzy_system_key));
+    if (sys != NULL) sys->fd = -1;
+    return sys;
+}
+
+static int syskey_create_generation(fuzzy_system_key *sys, uint64_t generation) {
+    if (syskey_map_new(sys, sys->name[0] ? sys->name : NULL) != 0) return -1;
+    int rc = syskey_populate(sys->base, sys->map_len, generation);
+    if (rc != 0) {
+        syskey_unmap(sys, 1);
+        return rc;
+    }
+    syskey_protect(sys, 0);
+    return 0;
+}
+
+int fuzzy_system_key_create(fuzzy_system_key **out, const char *name) {
+    if (out == NULL) return -1;
+    *out = NULL;
+
+    fuzzy_system_key *sys = syskey_alloc();
+    if (sys == NULL) return -1;
+    if (syskey_set_name(sys, name) != 0) {
+        free(sys);
+        return -1;
+    }
+    sys->owner = 1;
+
+    int rc = syskey_create_generation(sys, 1);
+    if (rc != 0) {
+        free(sys);
+        return rc;
+    }
+    *out = sys;
+    return 0;
+}
+
+int fuzzy_system_key_attach(fuzzy_system_key **out, const char *name) {
+    if (out == NULL || name == NULL) return -1;
+    *out = NULL;
+
+    fuzzy_system_key *sys = syskey_alloc();
+    if (sys == NULL) return -1;
+    if (syskey_set_name(sys, name) != 0 || syskey_map_existing(sys, name, -1) != 0) {
+        free(sys);
+        return -1;
+    }
+    *out = sys;
+    return 0;
+}
+
+int fuzzy_system_key_attach_fd(fuzzy_system_key **out, int fd) {
+    if (out == NULL || fd < 0) return -1;
+    *out = NULL;
+
+    fuzzy_system_key *sys = syskey_alloc();
+    if (sys == NULL) return -1;
+    if (syskey_map_existing(sys, NULL, fd) != 0) {
+        free(sys);
+        return -1;
+    }
+    *out = sys;
+    return 0;
+}
+
+int fuzzy_system_key_fd(const fuzzy_system_key *sys) {
+    if (sys == NULL || !sys->owner) return -1;
+    return sys->fd;
+}
+
+/* Hand the mapping of `next` to `sys`. The old mapping must already be
+ * owned elsewhere (the retired handle); only `base` is read concurrently. */
+static void syskey_install(fuzzy_system_key *sys, const fuzzy_system_key *next) {
+    sys->map_len = next->map_len;
+    sys->fd = next->fd;
+    sys->huge = next->huge;
+    memcpy(sys->name, next->name, sizeof(sys->name));
+    __atomic_store_n(&sys->base, next->base, __ATOMIC_RELEASE);
+}
+
+/* Move the current mapping of `sys` into a new retired handle. */
+static fuzzy_system_key *syskey_retire(const fuzzy_system_key *sys) {
+    fuzzy_system_key *old = syskey_alloc();
+    if (old == NULL) return NULL;
+    old->base = sys->base;
+    old->map_len = sys->map_len;
+    old->fd = sys->fd;
+    old->owner = sys->owner;
+    old->huge = sys->huge;
+    /* The name now belongs to the successor; never unlink it from here. */
+    old->name[0] = '\0';
+    return old;
+}
+
+int fuzzy_system_key_rotate(fuzzy_system_key *sys) {
+    if (sys == NULL || !sys->owner || sys->base == NULL || sys->retired != NULL) return -1;
+
+    fuzzy_system_key *old = syskey_retire(sys);
+    if (old == NULL) return -1;
+
+    uint64_t generation = syskey_header(sys)->generation + 1;
+    fuzzy_system_key next = *sys;
+    next.base = NULL;
+    next.fd = -1;
+    next.huge = 0;
+    next.retired = NULL;
+#ifndef _WIN32
+    if (sys->name[0] != '\0') {
+        /* Build the successor beside the live name; a leftover from an
+         * interrupted rotation of this name is discarded. */
+        snprintf(next.name, sizeof(next.name), "%.*s.g%llu", SYSKEY_NAME_MAX + 1, sys->name,
+                 (unsigned long long)generation);
+        shm_unlink(next.name);
+    }
+#endif
+    int rc = syskey_create_generation(&next, generation);
+    if (rc != 0) {
+        free(old);
+        return rc;
+    }
+#ifndef _WIN32
+    if (sys->name[0] != '\0' && syskey_publish(&next, sys->name, sys) != 0) {
+        syskey_unmap(&next, 1);
+        free(old);
+        return -1;
+    }
+#endif
+
+    /* Publish retirement only once the successor is in place. The old key
+     * material itself stays intact until fuzzy_system_key_release_retired(). */
+    syskey_protect(old, 1);
+    __atomic_store_n(&((syskey_header_t *)old->base)->retired, 1u, __ATOMIC_RELEASE);
+    syskey_protect(old, 0);
+
+    syskey_install(sys, &next);
+    sys->retired = old;
+    return 0;
+}
+
+int fuzzy_system_key_refresh(fuzzy_system_key *sys) {
+    if (sys == NULL || sys->base == NULL) return -1;
+    if (sys->owner) return 0;
+    if (!__atomic_load_n(&syskey_header(sys)->retired, __ATOMIC_ACQUIRE)) return 0;
+    /* Retired fd-based attachments need a new fd from the owner; a previous
+     * generation still held must be released first. */
+    if (sys->name[0] == '\0' || sys->retired != NULL) return -1;
+
+    fuzzy_system_key *old = syskey_retire(sys);
+    if (old == NULL) return -1;
+    fuzzy_system_key next = *sys;
+    next.base = NULL;
+    next.fd = -1;
+    next.retired = NULL;
+    if (syskey_map_existing(&next, next.name, -1) != 0) {
+        free(old);
+        return -1;
+    }
+
+    syskey_install(sys, &next);
+    sys->retired = old;
+    return 1;
+}
+
+const fuzzy_system_key *fuzzy_system_key_retired(const fuzzy_system_key *sys) {
+    return (sys == NULL) ? NULL : sys->retired;
+}
+
+void fuzzy_system_key_release_retired(fuzzy_system_key *sys) {
+    if (sys == NULL || sys->retired == NULL) return;
+    syskey_unmap(sys->retired, sys->owner);
+    free(sys->retired);
+    sys->retired = NULL;
+}
+
+void fuzzy_system_key_release(fuzzy_system_key *sys) {
+    if (sys == NULL) return;
+    fuzzy_system_key_release_retired(sys);
+    syskey_unmap(sys, sys->owner);
+    free(sys);
+}
+
+int fuzzy_system_key_id(const fuzzy_system_key *sys, uint8_t *id_out) {
+    if (sys == NULL || syskey_base(sys) == NULL || id_out == NULL) return -1;
+    memcpy(id_out, syskey_header(sys)->key_id, FUZZY_SYSTEM_KEY_ID_LEN);
+    return 0;
+}
+
+size_t fuzzy_system_key_footprint(const fuzzy_system_key *sys, size_t *heap_out) {
+    size_t map = 0, heap = 0;
+    for (const fuzzy_system_key *k = sys; k != NULL; k = k->retired) {
+        if (k->base != NULL) map += k->map_len;
+        heap += sizeof(*k);
+    }
+    if (heap_out != NULL) *heap_out = heap;
+    return map;
+}
+
+const uint8_t *fuzzy_system_key_public_key(const fuzzy_system_key *sys) {
+    const unsigned char *base = (sys == NULL) ? NULL : syskey_base(sys);
+    if (base == NULL) return NULL;
+    return base + SYSKEY_PK_OFFSET;
+}
+
+int code_offset_encode_shared(const fuzzy_system_key *sys,
+                              const uint8_t *w, size_t wlen,
+                              uint8_t *helper_out,
+                              uint8_t *key_out, size_t key_len) {
+    const unsigned char *base = (sys == NULL) ? NULL : syskey_base(sys);
+    if (base == NULL || helper_out == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+
+    unsigned char e_vec[SYS_N_BYTES];
+    code_offset_load_template(e_vec, w, wlen);
+
+    return code_offset_encode_evec_pk(e_vec, helper_out, base + SYSKEY_PK_OFFSET, key_out, key_len);
+}
+
+int code_offset_decode_shared(const fuzzy_system_key *sys,
+                              const uint8_t *wprime, size_t wlen,
+                              const uint8_t *helper,
+                              uint8_t *key_out, size_t key_len) {
+    const unsigned char *base = (sys == NULL) ? NULL : syskey_base(sys);
+    if (base == NULL || helper == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+
+    unsigned char e_prime[SYS_N_BYTES];
+    code_offset_load_template(e_prime, wprime, wlen);
+
+    return code_offset_decode_evec(e_prime, helper, base + SYSKEY_PK_OFFSET,
+                                   base + SYSKEY_SK_OFFSET, key_out, key_len);
+}
+
+int code_offset_decode_init_shared(code_offset_decode_ctx *ctx, const fuzzy_system_key *sys,
+                                   const uint8_t *helper) {
+    const unsigned char *base = (sys == NULL) ? NULL : syskey_base(sys);
+    if (base == NULL) return -1;
+    return code_offset_decode_init(ctx, helper, base + SYSKEY_PK_OFFSET, base + SYSKEY_SK_OFFSET);
+}
@@ -0,0 +1,354 @@
+// SPDX-License-Identifier: MIT
+
+#include "../fuzzy_extractor.h"
+#include "code_offset_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FUZZY_BIN_SSE2 1
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FUZZY_BIN_AVX 1
+#endif
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define FUZZY_BIN_BMI2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Bit counting on mask bytes (public helper data, never secret bits). */
+static inline unsigned bin_popcount(unsigned m) {
+#if defined(_MSC_VER)
+    return (unsigned)__popcnt(m);
+#else
+    return (unsigned)__builtin_popcount(m);
+#endif
+}
+
+/* Index of the lowest set bit; m must be non-zero. */
+static inline unsigned bin_ctz(unsigned m) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, m);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctz(m);
+#endif
+}
+
+/* --- Template binarization: quantize, select reliable bits, pack into e --- */
+
+/* The feature values are secret; the reliable-bit mask is helper data.
+ * Every loop below branches on `n` and mask bits only, never on a
+ * comparison result.
+ */
+
+/* 8-feature comparison kernels: bit k of the result is x[k] > thr[k]. */
+static inline unsigned binarize_f32_x8(const float *x, const float *thr) {
+#if defined(FUZZY_BIN_AVX)
+    __m256 t = thr ? _mm256_loadu_ps(thr) : _mm256_setzero_ps();
+    __m256 c = _mm256_cmp_ps(_mm256_loadu_ps(x), t, _CMP_GT_OQ);
+    return (unsigned)_mm256_movemask_ps(c);
+#elif defined(FUZZY_BIN_SSE2)
+    __m128 t0 = thr ? _mm_loadu_ps(thr) : _mm_setzero_ps();
+    __m128 t1 = thr ? _mm_loadu_ps(thr + 4) : _mm_setzero_ps();
+    unsigned lo = (unsigned)_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(x), t0));
+    unsigned hi = (unsigned)_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(x + 4), t1));
+    return lo | (hi << 4);
+#else
+    unsigned v = 0;
+    for (int k = 0; k < 8; k++) {
+        float t = thr ? thr[k] : 0.0f;
+        v |= (unsigned)(x[k] > t) << k;
+    }
+    return v;
+#endif
+}
+
+static inline unsigned binarize_i16_x8(const int16_t *x, const int16_t *thr) {
+#if defined(FUZZY_BIN_SSE2)
+    __m128i t = thr ? _mm_loadu_si128((const __m128i *)thr) : _mm_setzero_si128();
+    __m128i c = _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *)x), t);
+    return (unsigned)_mm_movemask_epi8(_mm_packs_epi16(c, _mm_setzero_si128()));
+#else
+    unsigned v = 0;
+    for (int k = 0; k < 8; k++) {
+        int16_t t = thr ? thr[k] : 0;
+        v |= (unsigned)(x[k] > t) << k;
+    }
+    return v;
+#endif
+}
+
+/* Gather the bits of v selected by m into the low popcount(m) bits. */
+static inline unsigned compress_bits8(unsigned v, unsigned m) {
+#if defined(FUZZY_BIN_BMI2)
+    return (unsigned)_pext_u32(v, m);
+#else
+    unsigned r = 0;
+    unsigned k = 0;
+    for (; m != 0; m &= m - 1) {
+        r |= ((v >> bin_ctz(m)) & 1u) << k;
+        k++;
+    }
+    return r;
+#endif
+}
+
+/* LSB-first bit writer that stores 64 bits at a time straight into e. */
+typedef struct {
+    uint8_t *out;
+    uint64_t acc;
+    unsigned fill;
+} bit_writer_t;
+
+static inline void bit_writer_store64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline void bit_writer_put(bit_writer_t *bw, unsigned bits, unsigned nbits) {
+    bw->acc |= (uint64_t)bits << bw->fill;
+    unsigned fill = bw->fill + nbits;
+    if (fill >= 64) {
+        bit_writer_store64(bw->out, bw->acc);
+        bw->out += 8;
+        bw->acc = bw->fill ? ((uint64_t)bits >> (64 - bw->fill)) : 0;
+        fill -= 64;
+    }
+    bw->fill = fill;
+}
+
+static inline uint8_t *bit_writer_flush(bit_writer_t *bw) {
+    unsigned nbytes = (bw->fill + 7) / 8;
+    for (unsigned i = 0; i < nbytes; i++) bw->out[i] = (uint8_t)(bw->acc >> (8 * i));
+    bw->acc = 0;
+    bw->fill = 0;
+    return bw->out + nbytes;
+}
+
+static inline unsigned mask_byte(const uint8_t *mask, size_t n, size_t i) {
+    unsigned m = mask ? mask[i / 8] : 0xFFu;
+    size_t left = n - i;
+    if (left < 8) m &= (1u << left) - 1u;
+    return m;
+}
+
+/* Number of selected features, or (size_t)-1 if they do not fit into e. */
+static size_t selected_bits(const uint8_t *mask, size_t n) {
+    size_t total = 0;
+    for (size_t i = 0; i < n; i += 8) {
+        total += bin_popcount(mask_byte(mask, n, i));
+    }
+    return (total > SYS_N_BITS) ? (size_t)-1 : total;
+}
+
+static void pack_f32(uint8_t *e_out, const float *x, const float *thr,
+                     const uint8_t *mask, size_t n) {
+    bit_writer_t bw = { e_out, 0, 0 };
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        unsigned m = mask_byte(mask, n, i);
+        if (m == 0) continue;
+        unsigned v = binarize_f32_x8(x + i, thr ? thr + i : NULL);
+        if (m == 0xFFu) {
+            bit_writer_put(&bw, v, 8);
+        } else {
+            bit_writer_put(&bw, compress_bits8(v, m), bin_popcount(m));
+        }
+    }
+    if (i < n) {
+        unsigned m = mask_byte(mask, n, i);
+        unsigned v = 0;
+        for (size_t k = 0; i + k < n; k++) {
+            float t = thr ? thr[i + k] : 0.0f;
+            v |= (unsigned)(x[i + k] > t) << k;
+        }
+        bit_writer_put(&bw, compress_bits8(v, m), bin_popcount(m));
+    }
+    uint8_t *end = bit_writer_flush(&bw);
+    memset(end, 0, (size_t)(e_out + SYS_N_BYTES - end));
+}
+
+static void pack_i16(uint8_t *e_out, const int16_t *x, const int16_t *thr,
+                     const uint8_t *mask, size_t n) {
+    bit_writer_t bw = { e_out, 0, 0 };
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        unsigned m = mask_byte(mask, n, i);
+        if (m == 0) continue;
+        unsigned v = binarize_i16_x8(x + i, thr ? thr + i : NULL);
+        if (m == 0xFFu) {
+            bit_writer_put(&bw, v, 8);
+        } else {
+            bit_writer_put(&bw, compress_bits8(v, m), bin_popcount(m));
+        }
+    }
+    if (i < n) {
+        unsigned m = mask_byte(mask, n, i);
+        unsigned v = 0;
+        for (size_t k = 0; i + k < n; k++) {
+            int16_t t = thr ? thr[i + k] : 0;
+            v |= (unsigned)(x[i + k] > t) << k;
+        }
+        bit_writer_put(&bw, compress_bits8(v, m), bin_popcount(m));
+    }
+    uint8_t *end = bit_writer_flush(&bw);
+    memset(end, 0, (size_t)(e_out + SYS_N_BYTES - end));
+}
+
+int fuzzy_binarize_f32(uint8_t *e_out, const float *x, const float *thresholds,
+                       const uint8_t *mask, size_t n) {
+    return fuzzy_binarize_f32_batch(e_out, x, 1, thresholds, mask, n);
+}
+
+int fuzzy_binarize_i16(uint8_t *e_out, const int16_t *x, const int16_t *thresholds,
+                       const uint8_t *mask, size_t n) {
+    return fuzzy_binarize_i16_batch(e_out, x, 1, thresholds, mask, n);
+}
+
+int fuzzy_binarize_f32_batch(uint8_t *e_out, const float *x, size_t count,
+                             const float *thresholds, const uint8_t *mask, size_t n) {
+    if (e_out == NULL || (x == NULL && n > 0 && count > 0)) return -1;
+    if (selected_bits(mask, n) == (size_t)-1) return -1;
+
+    for (size_t s = 0; s < count; s++) {
+        pack_f32(e_out + s * SYS_N_BYTES, x + s * n, thresholds, mask, n);
+    }
+    return 0;
+}
+
+int fuzzy_binarize_i16_batch(uint8_t *e_out, const int16_t *x, size_t count,
+                             const int16_t *thresholds, const uint8_t *mask, size_t n) {
+    if (e_out == NULL || (x == NULL && n > 0 && count > 0)) return -1;
+    if (selected_bits(mask, n) == (size_t)-1) return -1;
+
+    for (size_t s = 0; s < count; s++) {
+        pack_i16(e_out + s * SYS_N_BYTES, x + s * n, thresholds, mask, n);
+    }
+    return 0;
+}
+
+/* --- Reliable-bit selection (enrollment only, not constant-time) --- */
+
+typedef struct {
+    double reliability;
+    size_t index;
+} reliability_t;
+
+static int cmp_reliability_desc(const void *a, const void *b) {
+    const reliability_t *ra = (const reliability_t *)a;
+    const reliability_t *rb = (const reliability_t *)b;
+    if (ra->reliability != rb->reliability) return (ra->reliability < rb->reliability) ? 1 : -1;
+    return (ra->index > rb->index) - (ra->index < rb->index);
+}
+
+static int reliable_mask_finish(uint8_t *mask_out, reliability_t *rel, size_t n, size_t n_select) {
+    qsort(rel, n, sizeof(rel[0]), cmp_reliability_desc);
+    memset(mask_out, 0, (n + 7) / 8);
+    for (size_t k = 0; k < n_select; k++) {
+        size_t i = rel[k].index;
+        mask_out[i / 8] |= (uint8_t)(1u << (i % 8));
+    }
+    secure_memzero(rel, n * sizeof(rel[0]));
+    free(rel);
+    return 0;
+}
+
+int fuzzy_reliable_mask_f32(uint8_t *mask_out, const float *x, size_t count,
+                            const float *thresholds, size_t n, size_t n_select) {
+    if (mask_out == NULL || x == NULL || count == 0 || n == 0) return -1;
+    if (n_select > n || n_select > SYS_N_BITS) return -1;
+
+    reliability_t *rel = (reliability_t *)malloc(n * sizeof(reliability_t));
+    if (rel == NULL) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        double t = thresholds ? (double)thresholds[i] : 0.0;
+        double sum = 0.0;
+        for (size_t s = 0; s < count; s++) sum += (double)x[s * n + i] - t;
+        rel[i].reliability = (sum < 0.0 ? -sum : sum) / (double)count;
+        rel[i].index = i;
+    }
+    return reliable_mask_finish(mask_out, rel, n, n_select);
+}
+
+int fuzzy_reliable_mask_i16(uint8_t *mask_out, const int16_t *x, size_t count,
+                            const int16_t *thresholds, size_t n, size_t n_select) {
+    if (mask_out == NULL || x == NULL || count == 0 || n == 0) return -1;
+    if (n_select > n || n_select > SYS_N_BITS) return -1;
+
+    reliability_t *rel = (reliability_t *)malloc(n * sizeof(reliability_t));
+    if (rel == NULL) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        int64_t t = thresholds ? thresholds[i] : 0;
+        int64_t sum = 0;
+        for (size_t s = 0; s < count; s++) sum += (int64_t)x[s * n + i] - t;
+        rel[i].reliability = (double)(sum < 0 ? -sum : sum) / (double)count;
+        rel[i].index = i;
+    }
+    return reliable_mask_finish(mask_out, rel, n, n_select);
+}
+
+/* --- Code-offset front-ends over binarized templates --- */
+
+int code_offset_encode_f32(const float *x, const float *thresholds,
+                           const uint8_t *mask, size_t n,
+                           uint8_t *helper_out,
+                           uint8_t *public_key_out, uint8_t *secret_key_out,
+                           uint8_t *key_out, size_t key_len) {
+    if (helper_out == NULL || public_key_out == NULL || secret_key_out == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+
+    unsigned char e_vec[SYS_N_BYTES];
+    if (fuzzy_binarize_f32(e_vec, x, thresholds, mask, n) != 0) return -1;
+
+    return code_offset_encode_evec(e_vec, helper_out, public_key_out, secret_key_out, key_out, key_len);
+}
+
+int code_offset_decode_f32(const float *x, const float *thresholds,
+                           const uint8_t *mask, size_t n,
+                           const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                           uint8_t *key_out, size_t key_len) {
+    if (helper == NULL || public_key == NULL || secret_key == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+
+    unsigned char e_prime[SYS_N_BYTES];
+    if (fuzzy_binarize_f32(e_prime, x, thresholds, mask, n) != 0) return -1;
+
+    return code_offset_decode_evec(e_prime, helper, public_key, secret_key, key_out, key_len);
+}
+
+int code_offset_encode_i16(const int16_t *x, const int16_t *thresholds,
+                           const uint8_t *mask, size_t n,
+                           uint8_t *helper_out,
+                           uint8_t *public_key_out, uint8_t *secret_key_out,
+                           uint8_t *key_out, size_t key_len) {
+    if (helper_out == NULL || public_key_out == NULL || secret_key_out == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+
+    unsigned char e_vec[SYS_N_BYTES];
+    if (fuzzy_binarize_i16(e_vec, x, thresholds, mask, n) != 0) return -1;
+
+    return code_offset_encode_evec(e_vec, helper_out, public_key_out, secret_key_out, key_out, key_len);
+}
+
+int code_offset_decode_i16(const int16_t *x, const int16_t *thresholds,
+                           const uint8_t *mask, size_t n,
+                           const uint8_t *helper, const uint8_t *public_key, const uint8_t *secret_key,
+                           uint8_t *key_out, size_t key_len) {
+    if (helper == NULL || public_key == NULL || secret_key == NULL || key_out == NULL) return -1;
+    if (key_len == 0 || key_len > MCELIECE_348864F_SHARED_SECRET_LEN) return -1;
+
+    unsigned char e_prime[SYS_N_BYTES];
+    if (fuzzy_binarize_i16(e_prime, x, thresholds, mask, n) != 0) return -1;
+
+    return code_offset_decode_evec(e_prime, helper, public_key, secret_key, key_out, key_len);
+}
@@ -0,0 +1,426 @@
+// SPDX-License-Identifier: MIT
+// Stack and heap footprint of every public entry point, checked against the
+// budget in fuzzy_extractor.h.
+//
+// Each call runs once on a fresh thread with a painted stack (footprint.h)
+// to get its peak stack depth, PQClean / liboqs frames included. Heap use is
+// counted by building the library into this file with malloc / calloc / free
+// and the page-mapping calls routed through counters, so only allocations made
+// by this library are seen (liboqs allocates nothing on these paths). Calls
+// that create or drop a handle are budgeted with what the handle holds
+// afterwards, as reported by the fuzzy_*_footprint() helpers. Results go to
+// footprint_results.csv; the exit status is 1 if any call is over budget.
+//
+// -calibrate also prints each budget class's measured peak stack and the
+// FUZZY_STACK_BUDGET_* value it implies (peak + 25%, rounded up to 4 KB), the
+// rule the constants in fuzzy_extractor.h were derived with.
+//
+// usage: footprint [-out file.csv] [-calibrate]
+// build: compile this file alone (it includes ../fuzzy_extractor.c).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/* --- Allocation counters (peak and current bytes, heap and mappings) --- */
+
+typedef struct {
+    size_t cur;
+    size_t peak;
+} fp_counter_t;
+
+static fp_counter_t g_heap, g_map;
+
+static void fp_count_add(fp_counter_t *c, size_t n) {
+    size_t now = __atomic_add_fetch(&c->cur, n, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&c->peak, __ATOMIC_RELAXED);
+    while (now > peak && !__atomic_compare_exchange_n(&c->peak, &peak, now, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void fp_count_sub(fp_counter_t *c, size_t n) {
+    __atomic_sub_fetch(&c->cur, n, __ATOMIC_RELAXED);
+}
+
+/* Restart peak tracking at the current level; returns that level. */
+static size_t fp_count_mark(fp_counter_t *c) {
+    size_t now = __atomic_load_n(&c->cur, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->peak, now, __ATOMIC_RELAXED);
+    return now;
+}
+
+#define FP_HDR 16
+
+static void *fp_malloc(size_t n) {
+    unsigned char *p = (unsigned char *)malloc(n + FP_HDR);
+    if (p == NULL) return NULL;
+    memcpy(p, &n, sizeof(n));
+    fp_count_add(&g_heap, n);
+    return p + FP_HDR;
+}
+
+static void *fp_calloc(size_t count, size_t size) {
+    if (size != 0 && count > (SIZE_MAX - FP_HDR) / size) return NULL;
+    void *p = fp_malloc(count * size);
+    if (p != NULL) memset(p, 0, count * size);
+    return p;
+}
+
+static void fp_free(void *q) {
+    if (q == NULL) return;
+    unsigned char *p = (unsigned char *)q - FP_HDR;
+    size_t n;
+    memcpy(&n, p, sizeof(n));
+    fp_count_sub(&g_heap, n);
+    free(p);
+}
+
+#ifdef _WIN32
+static LPVOID fp_VirtualAlloc(LPVOID addr, SIZE_T len, DWORD type, DWORD prot) {
+    LPVOID p = VirtualAlloc(addr, len, type, prot);
+    if (p != NULL) fp_count_add(&g_map, len);
+    return p;
+}
+
+static LPVOID fp_VirtualAllocExNuma(HANDLE proc, LPVOID addr, SIZE_T len, DWORD type, DWORD prot, DWORD node) {
+    LPVOID p = VirtualAllocExNuma(proc, addr, len, type, prot, node);
+    if (p != NULL) fp_count_add(&g_map, len);
+    return p;
+}
+
+static BOOL fp_VirtualFree(LPVOID addr, SIZE_T len, DWORD type) {
+    MEMORY_BASIC_INFORMATION mbi;
+    if (type == MEM_RELEASE && VirtualQuery(addr, &mbi, sizeof(mbi)) != 0) len = mbi.RegionSize;
+    BOOL ok = VirtualFree(addr, 0, type);
+    if (ok) fp_count_sub(&g_map, len);
+    return ok;
+}
+
+#define VirtualAlloc(a, l, t, p) fp_VirtualAlloc(a, l, t, p)
+#define VirtualAllocExNuma(h, a, l, t, p, n) fp_VirtualAllocExNuma(h, a, l, t, p, n)
+#define VirtualFree(a, l, t) fp_VirtualFree(a, l, t)
+#else
+static void *fp_mmap(void *addr, size_t len, int prot, int flags, int fd, off_t off) {
+    void *p = mmap(addr, len, prot, flags, fd, off);
+    if (p != MAP_FAILED) fp_count_add(&g_map, len);
+    return p;
+}
+
+static int fp_munmap(void *addr, size_t len) {
+    int rc = munmap(addr, len);
+    if (rc == 0) fp_count_sub(&g_map, len);
+    return rc;
+}
+
+#define mmap(a, l, p, f, d, o) fp_mmap(a, l, p, f, d, o)
+#define munmap(a, l) fp_munmap(a, l)
+#endif
+
+#define malloc(n) fp_malloc(n)
+#define calloc(c, n) fp_calloc(c, n)
+#define free(p) fp_free(p)
+
+#include "../fuzzy_extractor.c"
+
+#undef malloc
+#undef calloc
+#undef free
+#ifdef _WIN32
+#undef VirtualAlloc
+#undef VirtualAllocExNuma
+#undef VirtualFree
+#else
+#undef mmap
+#undef munmap
+#endif
+
+#include "footprint.h"
+
+#define KEY_LEN MCELIECE_348864F_SHARED_SECRET_LEN
+#define NFEATURES 4096
+#define POOL_DEPTH 64
+
+/* --- Fixture shared by the measured calls --- */
+
+typedef struct {
+    uint8_t *pk, *sk, *pk2, *sk2;
+    uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t helper2[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t helper3[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t w[FUZZY_TEMPLATE_BYTES];
+    uint8_t wprimes[CODE_OFFSET_BATCH_MAX][FUZZY_TEMPLATE_BYTES];
+    const uint8_t *captures[3];
+    uint8_t fused[FUZZY_TEMPLATE_BYTES];
+    uint8_t key[KEY_LEN];
+    uint8_t keys[CODE_OFFSET_BATCH_MAX][KEY_LEN];
+    int rcs[CODE_OFFSET_BATCH_MAX];
+    uint8_t scratch[CODE_OFFSET_SCRATCH_BYTES];
+    code_offset_decode_ctx stream;
+    float xf[NFEATURES], thrf[NFEATURES];
+    int16_t xi[NFEATURES];
+    uint8_t mask[NFEATURES / 8];
+    fuzzy_system_key *sys;
+    fuzzy_key_replicas *replicas;
+    fuzzy_numa_pool *pool;
+    int rc;
+} fixture_t;
+
+static fixture_t fx;
+
+static void run_generate_key(void *a) { (void)a; fx.rc = fuzzy_generate_key(fx.key, KEY_LEN, fx.helper2, fx.pk2, fx.sk2); }
+static void run_reconstruct_key(void *a) { (void)a; fx.rc = fuzzy_reconstruct_key(fx.key, KEY_LEN, fx.helper2, fx.sk2); }
+static void run_kem_encode_like(void *a) { (void)a; fx.rc = mceliece_kem_encode_like(fx.w, FUZZY_TEMPLATE_BYTES, fx.helper2, fx.pk2, fx.sk2, fx.key, KEY_LEN); }
+static void run_kem_decode_like(void *a) { (void)a; fx.rc = mceliece_kem_decode_like(fx.w, FUZZY_TEMPLATE_BYTES, fx.helper2, fx.sk2, fx.key, KEY_LEN); }
+
+static void run_encode(void *a) { (void)a; fx.rc = code_offset_encode(fx.w, FUZZY_TEMPLATE_BYTES, fx.helper2, fx.pk2, fx.sk2, fx.key, KEY_LEN); }
+static void run_decode(void *a) { (void)a; fx.rc = code_offset_decode(fx.wprimes[0], FUZZY_TEMPLATE_BYTES, fx.helper, fx.pk, fx.sk, fx.key, KEY_LEN); }
+static void run_encode_scratch(void *a) {
+    (void)a;
+    fx.rc = code_offset_encode_scratch(fx.w, FUZZY_TEMPLATE_BYTES, fx.helper2, fx.pk, fx.key, KEY_LEN, fx.scratch, sizeof(fx.scratch));
+}
+static void run_decode_scratch(void *a) {
+    (void)a;
+    fx.rc = code_offset_decode_scratch(fx.wprimes[0], FUZZY_TEMPLATE_BYTES, fx.helper, fx.pk, fx.sk, fx.key, KEY_LEN,
+                                       fx.scratch, sizeof(fx.scratch));
+}
+static void run_decode_batch(void *a) {
+    (void)a;
+    fx.rc = code_offset_decode_batch(&fx.wprimes[0][0], FUZZY_TEMPLATE_BYTES, CODE_OFFSET_BATCH_MAX, fx.helper, fx.pk, fx.sk,
+                                     &fx.keys[0][0], KEY_LEN, fx.rcs);
+}
+static void run_stream_update(void *a) {
+    (void)a;
+    fx.rc = code_offset_decode_init(&fx.stream, fx.helper, fx.pk, fx.sk);
+    if (fx.rc == 0) fx.rc = code_offset_decode_update(&fx.stream, fx.wprimes[0], FUZZY_TEMPLATE_BYTES);
+}
+static void run_stream_final(void *a) { (void)a; fx.rc = code_offset_decode_final(&fx.stream, fx.key, KEY_LEN); }
+static void run_fuse(void *a) { (void)a; fx.rc = fuzzy_fuse_captures(fx.fused, fx.captures, NULL, 3, FUZZY_TEMPLATE_BYTES); }
+static void run_decode_fused(void *a) {
+    (void)a;
+    fx.rc = code_offset_decode_fused(fx.captures, NULL, 3, FUZZY_TEMPLATE_BYTES, FUZZY_FUSE_FALLBACK,
+                                     fx.helper, fx.pk, fx.sk, fx.key, KEY_LEN, NULL);
+}
+static void run_rekey(void *a) {
+    (void)a;
+    fx.rc = code_offset_rekey(fx.wprimes[0], FUZZY_TEMPLATE_BYTES, fx.helper, fx.pk, fx.sk, fx.pk2, fx.helper2, fx.key, KEY_LEN);
+}
+static void run_rekey_keygen(void *a) {
+    (void)a;
+    fx.rc = code_offset_rekey_keygen(fx.wprimes[0], FUZZY_TEMPLATE_BYTES, fx.helper, fx.pk, fx.sk, fx.helper2, fx.pk2, fx.sk2,
+                                     fx.key, KEY_LEN);
+}
+
+static void run_reliable_mask(void *a) {
+    (void)a;
+    fx.rc = fuzzy_reliable_mask_f32(fx.mask, fx.xf, 1, fx.thrf, NFEATURES, FUZZY_TEMPLATE_BITS);
+}
+static void run_binarize_f32(void *a) { (void)a; fx.rc = fuzzy_binarize_f32(fx.fused, fx.xf, fx.thrf, fx.mask, NFEATURES); }
+static void run_binarize_i16(void *a) { (void)a; fx.rc = fuzzy_binarize_i16(fx.fused, fx.xi, NULL, fx.mask, NFEATURES); }
+static void run_encode_f32(void *a) {
+    (void)a;
+    fx.rc = code_offset_encode_f32(fx.xf, fx.thrf, fx.mask, NFEATURES, fx.helper2, fx.pk2, fx.sk2, fx.key, KEY_LEN);
+}
+static void run_decode_f32(void *a) {
+    (void)a;
+    fx.rc = code_offset_decode_f32(fx.xf, fx.thrf, fx.mask, NFEATURES, fx.helper2, fx.pk2, fx.sk2, fx.key, KEY_LEN);
+}
+static void run_decode_i16(void *a) {
+    (void)a;
+    fx.rc = code_offset_decode_i16(fx.xi, NULL, fx.mask, NFEATURES, fx.helper2, fx.pk2, fx.sk2, fx.key, KEY_LEN);
+}
+
+static void run_syskey_create(void *a) { (void)a; fx.rc = fuzzy_system_key_create(&fx.sys, NULL); }
+static void run_encode_shared(void *a) { (void)a; fx.rc = code_offset_encode_shared(fx.sys, fx.w, FUZZY_TEMPLATE_BYTES, fx.helper2, fx.key, KEY_LEN); }
+static void run_decode_shared(void *a) { (void)a; fx.rc = code_offset_decode_shared(fx.sys, fx.w, FUZZY_TEMPLATE_BYTES, fx.helper2, fx.key, KEY_LEN); }
+static void run_rekey_shared(void *a) {
+    (void)a;
+    fx.rc = code_offset_rekey_shared(fx.wprimes[0], FUZZY_TEMPLATE_BYTES, fx.helper, fx.pk, fx.sk, fx.sys, fx.helper2, NULL, 0);
+}
+static void run_syskey_rotate(void *a) { (void)a; fx.rc = fuzzy_system_key_rotate(fx.sys); }
+static void run_rekey_system(void *a) {
+    (void)a;
+    fx.rc = code_offset_rekey_system(fx.w, FUZZY_TEMPLATE_BYTES, fx.helper2, fuzzy_system_key_retired(fx.sys), fx.sys,
+                                     fx.helper3, NULL, 0);
+}
+static void run_syskey_release_retired(void *a) { (void)a; fuzzy_system_key_release_retired(fx.sys); fx.rc = 0; }
+static void run_syskey_release(void *a) { (void)a; fuzzy_system_key_release(fx.sys); fx.sys = NULL; fx.rc = 0; }
+
+static void run_replicas_create(void *a) { (void)a; fx.rc = fuzzy_key_replicas_create(&fx.replicas, fx.pk, fx.sk); }
+static void run_decode_replicated(void *a) {
+    (void)a;
+    fx.rc = code_offset_decode_replicated(fx.replicas, fx.wprimes[0], FUZZY_TEMPLATE_BYTES, fx.helper, fx.key, KEY_LEN);
+}
+static void run_replicas_release(void *a) { (void)a; fuzzy_key_replicas_release(fx.replicas); fx.replicas = NULL; fx.rc = 0; }
+static void run_pool_create(void *a) { (void)a; fx.rc = fuzzy_numa_pool_create(&fx.pool, 1, POOL_DEPTH, CODE_OFFSET_SCRATCH_BYTES); }
+static void run_pool_destroy(void *a) { (void)a; fuzzy_numa_pool_destroy(fx.pool); fx.pool = NULL; fx.rc = 0; }
+
+/* Bytes held by the fixture's handles, from the library's own accounting. */
+static void held_syskey(size_t *map, size_t *heap) { *map = fuzzy_system_key_footprint(fx.sys, heap); }
+static void held_replicas(size_t *map, size_t *heap) { *map = fuzzy_key_replicas_footprint(fx.replicas, heap); }
+static void held_pool(size_t *map, size_t *heap) { *map = fuzzy_numa_pool_footprint(fx.pool, heap); }
+
+typedef struct {
+    const char *backend;
+    const char *entry;
+    const char *budget_name;
+    size_t stack_budget;
+    size_t heap_budget;   /* peak malloc bytes */
+    size_t map_budget;    /* peak mapped bytes */
+    footprint_fn fn;
+    /* If set, the heap and map budgets are what the handle holds after the
+     * call minus what it held before (an allocating call's peak must not
+     * exceed what it keeps). */
+    void (*held)(size_t *map, size_t *heap);
+} entry_t;
+
+#define KEYGEN "keygen", FUZZY_STACK_BUDGET_KEYGEN
+#define DECODE "decode", FUZZY_STACK_BUDGET_DECODE
+#define BATCH "batch", FUZZY_STACK_BUDGET_BATCH
+#define LIGHT "light", FUZZY_STACK_BUDGET_LIGHT
+
+static const char *const budget_names[] = { "keygen", "decode", "batch", "light" };
+#define NBUDGETS (sizeof(budget_names) / sizeof(budget_names[0]))
+
+static size_t budget_round(size_t peak) {
+    size_t b = peak + peak / 4;
+    return (b + 4095) / 4096 * 4096;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-out file.csv] [-calibrate]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = "footprint_results.csv";
+    int calibrate = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-out") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "-calibrate") == 0) calibrate = 1;
+        else { usage(argv[0]); return 1; }
+    }
+
+    fx.pk = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    fx.sk = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    fx.pk2 = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    fx.sk2 = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    if (!fx.pk || !fx.sk || !fx.pk2 || !fx.sk2) { fprintf(stderr, "alloc fail\n"); return 2; }
+
+    for (size_t i = 0; i < FUZZY_TEMPLATE_BYTES; i++) fx.w[i] = (uint8_t)rand();
+    if (code_offset_encode(fx.w, FUZZY_TEMPLATE_BYTES, fx.helper, fx.pk, fx.sk, fx.key, KEY_LEN) != 0) {
+        fprintf(stderr, "code_offset_encode fail\n");
+        return 3;
+    }
+    for (size_t k = 0; k < CODE_OFFSET_BATCH_MAX; k++) {
+        memcpy(fx.wprimes[k], fx.w, FUZZY_TEMPLATE_BYTES);
+        for (int i = 0; i < 20; i++) {
+            int pos = (int)((k * 389 + (size_t)i * 107) % FUZZY_TEMPLATE_BITS);
+            fx.wprimes[k][pos / 8] ^= (uint8_t)(1u << (pos % 8));
+        }
+    }
+    for (int c = 0; c < 3; c++) fx.captures[c] = fx.wprimes[c];
+    for (size_t i = 0; i < NFEATURES; i++) {
+        fx.xf[i] = (float)(rand() % 2001 - 1000) / 1000.0f;
+        fx.thrf[i] = 0.0f;
+        fx.xi[i] = (int16_t)(rand() % 2001 - 1000);
+    }
+
+    /* Order matters: later calls use the keys, contexts and handles created earlier. */
+    entry_t entries[] = {
+        { "kem", "fuzzy_generate_key", KEYGEN, 0, 0, run_generate_key, NULL },
+        { "kem", "fuzzy_reconstruct_key", DECODE, 0, 0, run_reconstruct_key, NULL },
+        { "kem", "mceliece_kem_encode_like", KEYGEN, 0, 0, run_kem_encode_like, NULL },
+        { "kem", "mceliece_kem_decode_like", DECODE, 0, 0, run_kem_decode_like, NULL },
+        { "code_offset", "code_offset_encode", KEYGEN, 0, 0, run_encode, NULL },
+        { "code_offset", "code_offset_decode", DECODE, 0, 0, run_decode, NULL },
+        { "code_offset", "code_offset_encode_scratch", LIGHT, 0, 0, run_encode_scratch, NULL },
+        { "code_offset", "code_offset_decode_scratch", DECODE, 0, 0, run_decode_scratch, NULL },
+        { "code_offset", "code_offset_decode_batch", BATCH, 0, 0, run_decode_batch, NULL },
+        { "code_offset", "code_offset_decode_init+update", LIGHT, 0, 0, run_stream_update, NULL },
+        { "code_offset", "code_offset_decode_final", DECODE, 0, 0, run_stream_final, NULL },
+        { "code_offset", "fuzzy_fuse_captures", LIGHT, 0, 0, run_fuse, NULL },
+        { "code_offset", "code_offset_decode_fused", DECODE, 0, 0, run_decode_fused, NULL },
+        { "code_offset", "code_offset_rekey", DECODE, 0, 0, run_rekey, NULL },
+        { "code_offset", "code_offset_rekey_keygen", KEYGEN, 0, 0, run_rekey_keygen, NULL },
+        { "template", "fuzzy_reliable_mask_f32", LIGHT, NFEATURES * 16, 0, run_reliable_mask, NULL },
+        { "template", "fuzzy_binarize_f32", LIGHT, 0, 0, run_binarize_f32, NULL },
+        { "template", "fuzzy_binarize_i16", LIGHT, 0, 0, run_binarize_i16, NULL },
+        { "template", "code_offset_encode_f32", KEYGEN, 0, 0, run_encode_f32, NULL },
+        { "template", "code_offset_decode_f32", DECODE, 0, 0, run_decode_f32, NULL },
+        { "template", "code_offset_decode_i16", DECODE, 0, 0, run_decode_i16, NULL },
+        { "system_key", "fuzzy_system_key_create", KEYGEN, 0, 0, run_syskey_create, held_syskey },
+        { "system_key", "code_offset_encode_shared", LIGHT, 0, 0, run_encode_shared, NULL },
+        { "system_key", "code_offset_decode_shared", DECODE, 0, 0, run_decode_shared, NULL },
+        { "system_key", "code_offset_rekey_shared", DECODE, 0, 0, run_rekey_shared, NULL },
+        { "system_key", "fuzzy_system_key_rotate", KEYGEN, 0, 0, run_syskey_rotate, held_syskey },
+        { "system_key", "code_offset_rekey_system", DECODE, 0, 0, run_rekey_system, NULL },
+        { "system_key", "fuzzy_system_key_release_retired", LIGHT, 0, 0, run_syskey_release_retired, held_syskey },
+        { "system_key", "fuzzy_system_key_release", LIGHT, 0, 0, run_syskey_release, held_syskey },
+        { "numa", "fuzzy_key_replicas_create", LIGHT, 0, 0, run_replicas_create, held_replicas },
+        { "numa", "code_offset_decode_replicated", DECODE, 0, 0, run_decode_replicated, NULL },
+        { "numa", "fuzzy_key_replicas_release", LIGHT, 0, 0, run_replicas_release, held_replicas },
+        { "numa", "fuzzy_numa_pool_create", LIGHT, 0, 0, run_pool_create, held_pool },
+        { "numa", "fuzzy_numa_pool_destroy", LIGHT, 0, 0, run_pool_destroy, held_pool },
+    };
+    size_t nentries = sizeof(entries) / sizeof(entries[0]);
+
+    FILE *csv = fopen(out_path, "wb");
+    FILE *out = csv ? csv : stdout;
+    fprintf(out, "backend,entry,budget,stack_bytes,stack_budget,heap_peak_bytes,heap_budget,"
+                 "map_peak_bytes,map_budget,rc,ok\n");
+
+    int over = 0;
+    size_t class_peak[NBUDGETS] = { 0 };
+    for (size_t i = 0; i < nentries; i++) {
+        entry_t *e = &entries[i];
+        size_t held_map0 = 0, held_heap0 = 0;
+        if (e->held != NULL) e->held(&held_map0, &held_heap0);
+        size_t heap0 = fp_count_mark(&g_heap);
+        size_t map0 = fp_count_mark(&g_map);
+        fx.rc = -1;
+
+        size_t stack = 0;
+        int started = footprint_stack_peak(e->fn, NULL, &stack) == 0;
+
+        size_t heap_peak = __atomic_load_n(&g_heap.peak, __ATOMIC_RELAXED) - heap0;
+        size_t map_peak = __atomic_load_n(&g_map.peak, __ATOMIC_RELAXED) - map0;
+        if (e->held != NULL) {
+            size_t held_map1 = 0, held_heap1 = 0;
+            e->held(&held_map1, &held_heap1);
+            e->map_budget = held_map1 > held_map0 ? held_map1 - held_map0 : 0;
+            e->heap_budget = held_heap1 > held_heap0 ? held_heap1 - held_heap0 : 0;
+        }
+        for (size_t b = 0; b < NBUDGETS; b++) {
+            if (strcmp(e->budget_name, budget_names[b]) == 0 && stack > class_peak[b]) class_peak[b] = stack;
+        }
+        int ok = started && stack <= e->stack_budget && heap_peak <= e->heap_budget && map_peak <= e->map_budget;
+        over += !ok;
+
+        fprintf(out, "%s,%s,%s,%zu,%zu,%zu,%zu,%zu,%zu,%d,%d\n", e->backend, e->entry, e->budget_name,
+                stack, e->stack_budget, heap_peak, e->heap_budget, map_peak, e->map_budget, fx.rc, ok);
+        fprintf(stderr, "[%s] %-32s stack %7zu / %7zu  heap %7zu / %7zu  map %8zu / %8zu  (rc=%d)\n",
+                ok ? "OK" : "OVER", e->entry, stack, e->stack_budget, heap_peak, e->heap_budget,
+                map_peak, e->map_budget, fx.rc);
+    }
+    fflush(out);
+    if (csv) fclose(csv);
+
+    if (calibrate) {
+        printf("class,peak_stack_bytes,derived_budget_bytes,current_budget_bytes\n");
+        const size_t current[NBUDGETS] = { FUZZY_STACK_BUDGET_KEYGEN, FUZZY_STACK_BUDGET_DECODE,
+                                           FUZZY_STACK_BUDGET_BATCH, FUZZY_STACK_BUDGET_LIGHT };
+        for (size_t b = 0; b < NBUDGETS; b++) {
+            printf("%s,%zu,%zu,%zu\n", budget_names[b], class_peak[b], budget_round(class_peak[b]), current[b]);
+        }
+    }
+
+    free(fx.pk); free(fx.sk); free(fx.pk2); free(fx.sk2);
+    fprintf(stderr, "\nSummary: %d over budget\n", over);
+    return (over == 0) ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+// Stack painting for the footprint tool and the timing harness.
+//
+// footprint_stack_peak(fn, arg, &peak) runs fn(arg) on a fresh thread with a
+// FOOTPRINT_THREAD_STACK stack. Before the call the thread fills the
+// FOOTPRINT_PAINT_BYTES below its own frame with a fixed pattern; afterwards
+// it scans that area from the deep end for the first overwritten byte. The
+// distance to the top of the area is the peak stack depth of fn, including
+// every library it calls. Stacks are assumed to grow downwards.
+#ifndef FUZZY_TESTS_FOOTPRINT_H
+#define FUZZY_TESTS_FOOTPRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define FOOTPRINT_PAINT_BYTES (1024 * 1024)
+#define FOOTPRINT_THREAD_STACK (4 * 1024 * 1024)
+#define FOOTPRINT_PATTERN 0xA5
+
+typedef void (*footprint_fn)(void *arg);
+
+typedef struct {
+    footprint_fn fn;
+    void *arg;
+    uintptr_t area;
+    size_t peak;
+} footprint_run_t;
+
+#if defined(__GNUC__)
+#define FOOTPRINT_NOINLINE __attribute__((noinline))
+#else
+#define FOOTPRINT_NOINLINE __declspec(noinline)
+#endif
+
+/* The painted frame is gone once this returns; its address is kept only to
+ * scan the same memory, which the measured call then reuses. */
+static FOOTPRINT_NOINLINE void footprint_paint(footprint_run_t *run) {
+    volatile uint8_t area[FOOTPRINT_PAINT_BYTES];
+    for (size_t i = 0; i < FOOTPRINT_PAINT_BYTES; i++) area[i] = FOOTPRINT_PATTERN;
+    run->area = (uintptr_t)area;
+}
+
+static FOOTPRINT_NOINLINE void footprint_scan(footprint_run_t *run) {
+    const volatile uint8_t *area = (const volatile uint8_t *)run->area;
+    size_t i = 0;
+    while (i < FOOTPRINT_PAINT_BYTES && area[i] == FOOTPRINT_PATTERN) i++;
+    run->peak = FOOTPRINT_PAINT_BYTES - i;
+}
+
+static FOOTPRINT_NOINLINE void footprint_thread_body(footprint_run_t *run) {
+    footprint_paint(run);
+    run->fn(run->arg);
+    footprint_scan(run);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI footprint_trampoline(LPVOID arg) {
+    footprint_thread_body((footprint_run_t *)arg);
+    return 0;
+}
+#else
+static void *footprint_trampoline(void *arg) {
+    footprint_thread_body((footprint_run_t *)arg);
+    return NULL;
+}
+#endif
+
+/* *peak_out = peak stack bytes used by fn(arg). Calls that never write
+ * below their caller's frame report 0. Returns -1 if no thread could be
+ * started. */
+static int footprint_stack_peak(footprint_fn fn, void *arg, size_t *peak_out) {
+    footprint_run_t run;
+    run.fn = fn;
+    run.arg = arg;
+    run.area = 0;
+    run.peak = 0;
+#ifdef _WIN32
+    HANDLE t = CreateThread(NULL, FOOTPRINT_THREAD_STACK, footprint_trampoline, &run,
+                            STACK_SIZE_PARAM_IS_A_RESERVATION, NULL);
+    if (t == NULL) return -1;
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_attr_t attr;
+    pthread_t t;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, FOOTPRINT_THREAD_STACK);
+    int rc = pthread_create(&t, &attr, footprint_trampoline, &run);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) return -1;
+    pthread_join(t, NULL);
+#endif
+    *peak_out = run.peak;
+    return 0;
+}
+
+#endif
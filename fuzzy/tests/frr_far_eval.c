@@ -0,0 +1,454 @@
+// SPDX-License-Identifier: MIT
+// Monte Carlo FRR/FAR evaluation for the Code-Offset fuzzy extractor.
+//
+// Runs random-error and burst-error genuine trials per error weight plus
+// impostor trials across all cores and writes FRR/FAR with 95% Wilson
+// confidence intervals. Every random choice (templates, keypairs, error
+// patterns) is drawn from a counter-based generator keyed by (seed, stream),
+// where the stream is derived from the trial's (config, index) and not from
+// the thread that runs it, so a run is reproducible from -seed alone,
+// independent of -threads. Batches of -batch trials share one enrollment,
+// so with -enrollments > 1 keep -batch fixed as well.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+static LARGE_INTEGER g_qpc_freq;
+static void init_timer(void) {
+    QueryPerformanceFrequency(&g_qpc_freq);
+}
+static double now_usec(void) {
+    LARGE_INTEGER cnt;
+    QueryPerformanceCounter(&cnt);
+    return (double)cnt.QuadPart * 1e6 / (double)g_qpc_freq.QuadPart;
+}
+static int cpu_count(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (int)si.dwNumberOfProcessors;
+}
+typedef HANDLE thread_t;
+static DWORD WINAPI thread_trampoline(LPVOID arg);
+static int thread_start(thread_t *t, void *arg) {
+    *t = CreateThread(NULL, 0, thread_trampoline, arg, 0, NULL);
+    return (*t == NULL) ? -1 : 0;
+}
+static void thread_join(thread_t t) {
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+}
+#else
+#include <sys/time.h>
+#include <pthread.h>
+#include <unistd.h>
+static void init_timer(void) { }
+static double now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec * 1e6 + (double)tv.tv_usec;
+}
+static int cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+}
+typedef pthread_t thread_t;
+static void *thread_trampoline(void *arg);
+static int thread_start(thread_t *t, void *arg) {
+    return pthread_create(t, NULL, thread_trampoline, arg);
+}
+static void thread_join(thread_t t) {
+    pthread_join(t, NULL);
+}
+#endif
+
+#include <oqs/rand.h>
+
+#include "../fuzzy_extractor.h"
+
+/* Parameters for Classic McEliece 348864f */
+#define SYS_N_BITS 3488
+#define SYS_N_BYTES (SYS_N_BITS / 8)
+#define KEY_LEN MCELIECE_348864F_SHARED_SECRET_LEN
+
+/* --- Counter-based RNG: output i of stream s is mix(key(seed, s) + i * phi) --- */
+
+#define RNG_GOLDEN 0x9E3779B97F4A7C15ULL
+#define STREAM_ENROLL 0xE0000000000000ULL
+#define STREAM_KEYGEN 0xE1000000000000ULL
+
+typedef struct {
+    uint64_t key;
+    uint64_t ctr;
+} ctr_rng_t;
+
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void ctr_rng_init(ctr_rng_t *r, uint64_t seed, uint64_t stream) {
+    r->key = mix64(seed ^ mix64(stream + RNG_GOLDEN));
+    r->ctr = 0;
+}
+
+static uint64_t ctr_rng_next(ctr_rng_t *r) {
+    r->ctr++;
+    return mix64(r->key + r->ctr * RNG_GOLDEN);
+}
+
+/* Uniform in [0, bound) via 32x32 multiply-high (bias < 2^-20 for our bounds). */
+static uint32_t ctr_rng_below(ctr_rng_t *r, uint32_t bound) {
+    return (uint32_t)(((ctr_rng_next(r) >> 32) * (uint64_t)bound) >> 32);
+}
+
+static void ctr_rng_fill(ctr_rng_t *r, uint8_t *out, size_t n) {
+    while (n >= 8) {
+        uint64_t v = ctr_rng_next(r);
+        for (int i = 0; i < 8; i++) out[i] = (uint8_t)(v >> (8 * i));
+        out += 8;
+        n -= 8;
+    }
+    if (n > 0) {
+        uint64_t v = ctr_rng_next(r);
+        for (size_t i = 0; i < n; i++) out[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+/* McEliece keygen draws from OQS_randombytes; route it to the seeded
+ * generator while enrolling (single-threaded, before workers start). */
+static ctr_rng_t g_keygen_rng;
+static void seeded_randombytes(uint8_t *out, size_t n) {
+    ctr_rng_fill(&g_keygen_rng, out, n);
+}
+
+/* --- Error patterns --- */
+
+static inline void flip_bit(uint8_t *v, uint32_t pos) {
+    v[pos / 8] ^= (uint8_t)(1u << (pos % 8));
+}
+
+static inline int test_bit(const uint8_t *v, uint32_t pos) {
+    return (v[pos / 8] >> (pos % 8)) & 1;
+}
+
+/* `weight` distinct positions in [0, nbits) via Floyd's sampling. */
+static void add_random_errors(uint8_t *wprime, ctr_rng_t *r, uint32_t nbits, uint32_t weight) {
+    uint8_t chosen[SYS_N_BYTES];
+    memset(chosen, 0, sizeof(chosen));
+    for (uint32_t j = nbits - weight; j < nbits; j++) {
+        uint32_t t = ctr_rng_below(r, j + 1);
+        uint32_t pos = test_bit(chosen, t) ? j : t;
+        flip_bit(chosen, pos);
+        flip_bit(wprime, pos);
+    }
+}
+
+/* One contiguous run of `weight` flipped bits, wrapping inside [0, nbits). */
+static void add_burst_errors(uint8_t *wprime, ctr_rng_t *r, uint32_t nbits, uint32_t weight) {
+    uint32_t start = ctr_rng_below(r, nbits);
+    for (uint32_t k = 0; k < weight; k++) {
+        flip_bit(wprime, (start + k) % nbits);
+    }
+}
+
+/* --- Trial configurations --- */
+
+typedef enum { MODE_RANDOM = 0, MODE_BURST = 1, MODE_IMPOSTOR = 2 } trial_mode_t;
+
+static const char *mode_name(trial_mode_t m) {
+    switch (m) {
+        case MODE_RANDOM: return "random";
+        case MODE_BURST: return "burst";
+        default: return "impostor";
+    }
+}
+
+typedef struct {
+    trial_mode_t mode;
+    int errors;        /* -1 for impostor trials */
+    uint64_t trials;
+    uint64_t chunks;   /* ceil(trials / batch) */
+    uint64_t first_job;
+} trial_config_t;
+
+typedef struct {
+    uint8_t w[SYS_N_BYTES];
+    uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t key[KEY_LEN];
+    uint8_t *pk;
+    uint8_t *sk;
+} enrollment_t;
+
+typedef struct {
+    uint64_t seed;
+    uint32_t nbits;
+    size_t batch;
+    const trial_config_t *configs;
+    size_t nconfigs;
+    uint64_t njobs;
+    const enrollment_t *enrollments;
+    size_t nenrollments;
+    uint64_t next_job;   /* shared work counter */
+} eval_ctx_t;
+
+typedef struct {
+    eval_ctx_t *ctx;
+    uint64_t *failures;  /* per config */
+    int status;
+} worker_t;
+
+static size_t job_config(const eval_ctx_t *ctx, uint64_t job) {
+    size_t c = 0;
+    while (c + 1 < ctx->nconfigs && job >= ctx->configs[c + 1].first_job) c++;
+    return c;
+}
+
+static void run_job(const eval_ctx_t *ctx, uint64_t job, uint64_t *failures,
+                    uint8_t *wprimes, uint8_t *keys, int *rcs) {
+    size_t c = job_config(ctx, job);
+    const trial_config_t *cfg = &ctx->configs[c];
+    uint64_t chunk = job - cfg->first_job;
+    const enrollment_t *en = &ctx->enrollments[chunk % ctx->nenrollments];
+
+    uint64_t t0 = chunk * ctx->batch;
+    size_t n = (size_t)((cfg->trials - t0 < ctx->batch) ? cfg->trials - t0 : ctx->batch);
+
+    for (size_t k = 0; k < n; k++) {
+        ctr_rng_t r;
+        ctr_rng_init(&r, ctx->seed, ((uint64_t)c << 40) | (t0 + k));
+        uint8_t *wp = wprimes + k * SYS_N_BYTES;
+        if (cfg->mode == MODE_IMPOSTOR) {
+            ctr_rng_fill(&r, wp, SYS_N_BYTES);
+        } else {
+            memcpy(wp, en->w, SYS_N_BYTES);
+            if (cfg->mode == MODE_RANDOM) {
+                add_random_errors(wp, &r, ctx->nbits, (uint32_t)cfg->errors);
+            } else {
+                add_burst_errors(wp, &r, ctx->nbits, (uint32_t)cfg->errors);
+            }
+        }
+    }
+
+    (void)code_offset_decode_batch(wprimes, SYS_N_BYTES, n, en->helper, en->pk, en->sk, keys, KEY_LEN, rcs);
+
+    for (size_t k = 0; k < n; k++) {
+        int match = (rcs[k] == 0 && constant_time_compare(en->key, keys + k * KEY_LEN, KEY_LEN));
+        /* Genuine: failure = false reject. Impostor: failure = false accept. */
+        failures[c] += (cfg->mode == MODE_IMPOSTOR) ? (uint64_t)match : (uint64_t)!match;
+    }
+}
+
+static void worker_main(worker_t *wk) {
+    eval_ctx_t *ctx = wk->ctx;
+    uint8_t *wprimes = (uint8_t *)malloc(ctx->batch * SYS_N_BYTES);
+    uint8_t *keys = (uint8_t *)malloc(ctx->batch * KEY_LEN);
+    int *rcs = (int *)malloc(ctx->batch * sizeof(int));
+    if (!wprimes || !keys || !rcs) {
+        wk->status = -1;
+    } else {
+        for (;;) {
+            uint64_t job = __atomic_fetch_add(&ctx->next_job, 1, __ATOMIC_RELAXED);
+            if (job >= ctx->njobs) break;
+            run_job(ctx, job, wk->failures, wprimes, keys, rcs);
+        }
+    }
+    free(wprimes); free(keys); free(rcs);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_trampoline(LPVOID arg) {
+    worker_main((worker_t *)arg);
+    return 0;
+}
+#else
+static void *thread_trampoline(void *arg) {
+    worker_main((worker_t *)arg);
+    return NULL;
+}
+#endif
+
+/* 95% Wilson score interval for k failures out of n. */
+static void wilson_interval(uint64_t k, uint64_t n, double *lo, double *hi) {
+    const double z = 1.959963984540054;
+    if (n == 0) { *lo = 0.0; *hi = 1.0; return; }
+    double p = (double)k / (double)n;
+    double dn = (double)n;
+    double denom = 1.0 + z * z / dn;
+    double center = (p + z * z / (2.0 * dn)) / denom;
+    double half = z * sqrt(p * (1.0 - p) / dn + z * z / (4.0 * dn * dn)) / denom;
+    *lo = (center - half < 0.0) ? 0.0 : center - half;
+    *hi = (center + half > 1.0) ? 1.0 : center + half;
+    if (k == 0) *lo = 0.0;
+    if (k == n) *hi = 1.0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [-seed S] [-trials N] [-far_trials M] [-min_errors A] [-max_errors B]\n"
+            "          [-step K] [-mode random|burst|both] [-threads T] [-batch B]\n"
+            "          [-enrollments E] [-bits L] [-out file.csv]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = 1;
+    uint64_t trials = 10000;
+    uint64_t far_trials = 10000;
+    int min_errors = 0, max_errors = 80, step = 1;
+    int modes = 3; /* bit 0 random, bit 1 burst */
+    int threads = cpu_count();
+    size_t batch = CODE_OFFSET_BATCH_MAX;
+    size_t nenroll = 1;
+    uint32_t nbits = SYS_N_BITS;
+    const char *out_path = "frr_far_results.csv";
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (v == NULL) { usage(argv[0]); return 1; }
+        if (strcmp(a, "-seed") == 0) seed = strtoull(v, NULL, 0);
+        else if (strcmp(a, "-trials") == 0) trials = strtoull(v, NULL, 0);
+        else if (strcmp(a, "-far_trials") == 0) far_trials = strtoull(v, NULL, 0);
+        else if (strcmp(a, "-min_errors") == 0) min_errors = atoi(v);
+        else if (strcmp(a, "-max_errors") == 0) max_errors = atoi(v);
+        else if (strcmp(a, "-step") == 0) step = atoi(v);
+        else if (strcmp(a, "-mode") == 0) {
+            if (strcmp(v, "random") == 0) modes = 1;
+            else if (strcmp(v, "burst") == 0) modes = 2;
+            else if (strcmp(v, "both") == 0) modes = 3;
+            else { fprintf(stderr, "unknown -mode '%s'\n", v); usage(argv[0]); return 1; }
+        }
+        else if (strcmp(a, "-threads") == 0) threads = atoi(v);
+        else if (strcmp(a, "-batch") == 0) batch = (size_t)atoi(v);
+        else if (strcmp(a, "-enrollments") == 0) nenroll = (size_t)atoi(v);
+        else if (strcmp(a, "-bits") == 0) nbits = (uint32_t)atoi(v);
+        else if (strcmp(a, "-out") == 0) out_path = v;
+        else { usage(argv[0]); return 1; }
+        i++;
+    }
+    if (threads < 1) threads = 1;
+    if (batch < 1) batch = 1;
+    if (nenroll < 1) nenroll = 1;
+    if (step < 1) step = 1;
+    if (nbits < 1 || nbits > SYS_N_BITS) nbits = SYS_N_BITS;
+    if (min_errors < 0) min_errors = 0;
+    if (max_errors > (int)nbits) max_errors = (int)nbits;
+    if (min_errors > max_errors) {
+        fprintf(stderr, "-min_errors (%d) exceeds -max_errors (%d)\n", min_errors, max_errors);
+        usage(argv[0]);
+        return 1;
+    }
+
+    init_timer();
+
+    /* Enrollments: seeded templates and seeded keypairs. */
+    enrollment_t *enrollments = (enrollment_t *)calloc(nenroll, sizeof(enrollment_t));
+    if (!enrollments) { fprintf(stderr, "alloc fail\n"); return 2; }
+    OQS_randombytes_custom_algorithm(seeded_randombytes);
+    for (size_t e = 0; e < nenroll; e++) {
+        enrollment_t *en = &enrollments[e];
+        ctr_rng_t r;
+        ctr_rng_init(&r, seed, STREAM_ENROLL + e);
+        ctr_rng_init(&g_keygen_rng, seed, STREAM_KEYGEN + e);
+        ctr_rng_fill(&r, en->w, SYS_N_BYTES);
+        en->pk = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+        en->sk = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+        if (!en->pk || !en->sk) { fprintf(stderr, "alloc fail\n"); return 2; }
+        if (code_offset_encode(en->w, SYS_N_BYTES, en->helper, en->pk, en->sk, en->key, KEY_LEN) != 0) {
+            fprintf(stderr, "code_offset_encode fail\n");
+            return 3;
+        }
+    }
+
+    /* Configs: one per (mode, weight) plus one impostor config. */
+    size_t max_configs = 2 * (size_t)((max_errors - min_errors) / step + 1) + 1;
+    trial_config_t *configs = (trial_config_t *)calloc(max_configs, sizeof(trial_config_t));
+    if (!configs) { fprintf(stderr, "alloc fail\n"); return 2; }
+    size_t nconfigs = 0;
+    for (int m = 0; m < 2; m++) {
+        if (!(modes & (1 << m))) continue;
+        for (int w = min_errors; w <= max_errors; w += step) {
+            configs[nconfigs].mode = (trial_mode_t)m;
+            configs[nconfigs].errors = w;
+            configs[nconfigs].trials = trials;
+            nconfigs++;
+        }
+    }
+    if (far_trials > 0) {
+        configs[nconfigs].mode = MODE_IMPOSTOR;
+        configs[nconfigs].errors = -1;
+        configs[nconfigs].trials = far_trials;
+        nconfigs++;
+    }
+
+    eval_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.seed = seed;
+    ctx.nbits = nbits;
+    ctx.batch = batch;
+    ctx.configs = configs;
+    ctx.nconfigs = nconfigs;
+    ctx.enrollments = enrollments;
+    ctx.nenrollments = nenroll;
+    for (size_t c = 0; c < nconfigs; c++) {
+        configs[c].chunks = (configs[c].trials + batch - 1) / batch;
+        configs[c].first_job = ctx.njobs;
+        ctx.njobs += configs[c].chunks;
+    }
+
+    fprintf(stderr, "[eval] seed=%llu threads=%d batch=%zu enrollments=%zu bits=%u configs=%zu\n",
+            (unsigned long long)seed, threads, batch, nenroll, nbits, nconfigs);
+
+    worker_t *workers = (worker_t *)calloc((size_t)threads, sizeof(worker_t));
+    thread_t *tids = (thread_t *)calloc((size_t)threads, sizeof(thread_t));
+    if (!workers || !tids) { fprintf(stderr, "alloc fail\n"); return 2; }
+
+    double t_start = now_usec();
+    for (int t = 0; t < threads; t++) {
+        workers[t].ctx = &ctx;
+        workers[t].failures = (uint64_t *)calloc(nconfigs, sizeof(uint64_t));
+        if (!workers[t].failures || thread_start(&tids[t], &workers[t]) != 0) {
+            fprintf(stderr, "thread start fail\n");
+            return 2;
+        }
+    }
+    for (int t = 0; t < threads; t++) thread_join(tids[t]);
+    double elapsed = (now_usec() - t_start) / 1e6;
+
+    uint64_t total_trials = 0;
+    for (int t = 0; t < threads; t++) {
+        if (workers[t].status != 0) { fprintf(stderr, "worker %d failed\n", t); return 2; }
+    }
+
+    FILE *csv = fopen(out_path, "wb");
+    FILE *out = csv ? csv : stdout;
+    fprintf(out, "mode,errors,trials,failures,rate,ci95_lo,ci95_hi\n");
+    for (size_t c = 0; c < nconfigs; c++) {
+        uint64_t k = 0;
+        for (int t = 0; t < threads; t++) k += workers[t].failures[c];
+        double lo, hi;
+        wilson_interval(k, configs[c].trials, &lo, &hi);
+        fprintf(out, "%s,%d,%llu,%llu,%.6g,%.6g,%.6g\n",
+                mode_name(configs[c].mode), configs[c].errors,
+                (unsigned long long)configs[c].trials, (unsigned long long)k,
+                configs[c].trials ? (double)k / (double)configs[c].trials : 0.0, lo, hi);
+        total_trials += configs[c].trials;
+    }
+    fflush(out);
+    if (csv) fclose(csv);
+
+    fprintf(stderr, "[eval] %llu trials in %.2f s (%.0f trials/s) -> %s\n",
+            (unsigned long long)total_trials, elapsed,
+            elapsed > 0.0 ? (double)total_trials / elapsed : 0.0, csv ? out_path : "stdout");
+
+    for (int t = 0; t < threads; t++) free(workers[t].failures);
+    free(workers); free(tids); free(configs);
+    for (size_t e = 0; e < nenroll; e++) { free(enrollments[e].pk); free(enrollments[e].sk); }
+    free(enrollments);
+    return 0;
+}
@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: MIT
+// NUMA placement benchmark: decode throughput with the key on the workers'
+// own node vs. on a remote node vs. per-node replicas. Scenarios that are
+// compared with each other run on the same number of worker threads: one
+// node's workers for local / cross_node / replicated, every node's workers
+// for all_shared / all_replicated.
+//
+// usage: numa_bench [decodes_per_scenario] [threads_per_node]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+static LARGE_INTEGER g_qpc_freq;
+static void init_timer(void) {
+    QueryPerformanceFrequency(&g_qpc_freq);
+}
+static double now_usec(void) {
+    LARGE_INTEGER cnt;
+    QueryPerformanceCounter(&cnt);
+    return (double)cnt.QuadPart * 1e6 / (double)g_qpc_freq.QuadPart;
+}
+#else
+#include <sys/time.h>
+static void init_timer(void) { }
+static double now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec * 1e6 + (double)tv.tv_usec;
+}
+#endif
+
+#include "../fuzzy_extractor.h"
+
+#define SYS_N_BYTES FUZZY_TEMPLATE_BYTES
+#define KEY_LEN MCELIECE_348864F_SHARED_SECRET_LEN
+
+typedef struct {
+    const uint8_t *pk;             /* NULL: use replicas */
+    const uint8_t *sk;
+    const fuzzy_key_replicas *replicas;
+    const uint8_t *helper;
+    const uint8_t *wprime;
+    const uint8_t *key_ref;
+    int ok;
+} decode_job_t;
+
+static void decode_task(void *arg, int node, void *scratch, size_t scratch_len) {
+    decode_job_t *job = (decode_job_t *)arg;
+    uint8_t key[KEY_LEN];
+    int rc;
+    (void)scratch; (void)scratch_len;
+    if (job->pk != NULL) {
+        rc = code_offset_decode(job->wprime, SYS_N_BYTES, job->helper, job->pk, job->sk, key, KEY_LEN);
+    } else {
+        rc = code_offset_decode(job->wprime, SYS_N_BYTES, job->helper,
+                                fuzzy_key_replicas_public_key(job->replicas, node),
+                                fuzzy_key_replicas_secret_key(job->replicas, node), key, KEY_LEN);
+    }
+    job->ok = (rc == 0 && constant_time_compare(key, job->key_ref, KEY_LEN));
+}
+
+static void noop_task(void *arg, int node, void *scratch, size_t scratch_len) {
+    (void)arg; (void)node; (void)scratch; (void)scratch_len;
+}
+
+/* Nodes without CPUs have no workers and the pool reroutes their work, so
+ * probe with a no-op: node n has workers iff a submit to n runs on n. */
+static int node_has_workers(fuzzy_numa_pool *pool, int node) {
+    int used = fuzzy_numa_pool_submit(pool, node, noop_task, NULL);
+    fuzzy_numa_pool_wait(pool);
+    return used == node;
+}
+
+/* Submit n decodes; worker_node < 0 spreads them round robin. A failed
+ * submit, or one routed away from worker_node, fails the scenario. */
+static double run_scenario(fuzzy_numa_pool *pool, decode_job_t *jobs, size_t n, int worker_node, int *ok_out) {
+    int ok = 1;
+    double t0 = now_usec();
+    for (size_t i = 0; i < n; i++) {
+        int used = fuzzy_numa_pool_submit(pool, worker_node, decode_task, &jobs[i]);
+        if (used < 0 || (worker_node >= 0 && used != worker_node)) {
+            fprintf(stderr, "[numa] submit to node %d failed (rc=%d)\n", worker_node, used);
+            ok = 0;
+            break;
+        }
+    }
+    fuzzy_numa_pool_wait(pool);
+    double secs = (now_usec() - t0) / 1e6;
+    for (size_t i = 0; i < n; i++) ok &= jobs[i].ok;
+    *ok_out = ok;
+    return secs > 0.0 ? (double)n / secs : 0.0;
+}
+
+int main(int argc, char **argv) {
+    size_t n = (argc >= 2 && atoi(argv[1]) > 0) ? (size_t)atoi(argv[1]) : 2000;
+    int threads_per_node = (argc >= 3 && atoi(argv[2]) > 0) ? atoi(argv[2]) : 4;
+
+    init_timer();
+    int nnodes = fuzzy_numa_node_count();
+
+    uint8_t *pk = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    uint8_t *sk = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t w[SYS_N_BYTES], wprime[SYS_N_BYTES], key_ref[KEY_LEN];
+    if (!pk || !sk) { fprintf(stderr, "alloc fail\n"); return 2; }
+
+    for (size_t i = 0; i < SYS_N_BYTES; i++) w[i] = (uint8_t)rand();
+    if (code_offset_encode(w, SYS_N_BYTES, helper, pk, sk, key_ref, KEY_LEN) != 0) {
+        fprintf(stderr, "code_offset_encode fail\n");
+        return 3;
+    }
+    memcpy(wprime, w, SYS_N_BYTES);
+    for (int i = 0; i < 40; i++) wprime[(i * 11) % SYS_N_BYTES] ^= (uint8_t)(1u << (i % 8));
+
+    /* Key pinned on node 0. */
+    uint8_t *pk0 = (uint8_t *)fuzzy_numa_alloc(MCELIECE_348864F_PUBLIC_KEY_LEN, 0);
+    uint8_t *sk0 = (uint8_t *)fuzzy_numa_alloc(MCELIECE_348864F_SECRET_KEY_LEN, 0);
+    fuzzy_key_replicas *replicas = NULL;
+    if (!pk0 || !sk0 || fuzzy_key_replicas_create(&replicas, pk, sk) != 0) {
+        fprintf(stderr, "numa alloc fail\n");
+        return 2;
+    }
+    memcpy(pk0, pk, MCELIECE_348864F_PUBLIC_KEY_LEN);
+    memcpy(sk0, sk, MCELIECE_348864F_SECRET_KEY_LEN);
+
+    fuzzy_numa_pool *pool = NULL;
+    if (fuzzy_numa_pool_create(&pool, threads_per_node, 64, 0) != 0) {
+        fprintf(stderr, "pool create fail\n");
+        return 2;
+    }
+
+    decode_job_t *jobs = (decode_job_t *)calloc(n, sizeof(decode_job_t));
+    if (!jobs) { fprintf(stderr, "alloc fail\n"); return 2; }
+
+    /* Remote = the last node that has workers; memory-only nodes would
+     * silently run the work on node 0. */
+    int remote = 0;
+    int worker_nodes = 0;
+    for (int nd = 0; nd < nnodes; nd++) {
+        if (!node_has_workers(pool, nd)) {
+            if (nd == 0) {
+                fprintf(stderr, "[numa] node 0 has no CPUs; the local scenario needs it\n");
+                return 2;
+            }
+            continue;
+        }
+        worker_nodes++;
+        remote = nd;
+    }
+
+    fprintf(stderr, "[numa] nodes=%d nodes_with_cpus=%d threads_per_node=%d decodes=%zu key_node=%d remote=%d\n",
+            nnodes, worker_nodes, threads_per_node, n, fuzzy_numa_node_of(pk0), remote);
+    if (remote == 0) fprintf(stderr, "[numa] only node 0 has CPUs: the remote scenarios run locally\n");
+
+    printf("scenario,key_node,worker_node,threads,decodes,decodes_per_s,all_ok\n");
+
+    struct { const char *name; int replicated; int worker_node; } scenarios[] = {
+        { "local", 0, 0 },
+        { "cross_node", 0, remote },
+        { "replicated", 1, remote },
+        { "all_shared", 0, -1 },
+        { "all_replicated", 1, -1 },
+    };
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+        for (size_t i = 0; i < n; i++) {
+            jobs[i].pk = scenarios[s].replicated ? NULL : pk0;
+            jobs[i].sk = scenarios[s].replicated ? NULL : sk0;
+            jobs[i].replicas = replicas;
+            jobs[i].helper = helper;
+            jobs[i].wprime = wprime;
+            jobs[i].key_ref = key_ref;
+            jobs[i].ok = 0;
+        }
+        int ok = 0;
+        double tput = run_scenario(pool, jobs, n, scenarios[s].worker_node, &ok);
+        int threads = threads_per_node * (scenarios[s].worker_node < 0 ? worker_nodes : 1);
+        printf("%s,%s,%s,%d,%zu,%.1f,%d\n", scenarios[s].name,
+               scenarios[s].replicated ? "all" : "0",
+               scenarios[s].worker_node < 0 ? "all" : (scenarios[s].worker_node == 0 ? "0" : "remote"),
+               threads, n, tput, ok);
+        fflush(stdout);
+    }
+
+    fuzzy_numa_pool_destroy(pool);
+    fuzzy_key_replicas_release(replicas);
+    fuzzy_numa_free(pk0, MCELIECE_348864F_PUBLIC_KEY_LEN);
+    fuzzy_numa_free(sk0, MCELIECE_348864F_SECRET_KEY_LEN);
+    free(jobs); free(pk); free(sk);
+    return 0;
+}
@@ -0,0 +1,312 @@
+// SPDX-License-Identifier: MIT
+// Bulk helper re-keying for McEliece key rotation.
+//
+// Streams an enrollment file of (id, fresh sample w', old helper, old keypair)
+// records, re-keys every record with code_offset_rekey_*() on a worker pool
+// spanning all cores, and writes the new helpers in input order. Records are
+// processed in chunks, so memory stays bounded by -chunk regardless of the
+// file size: the next chunk is read while the current one is re-keyed, and
+// both the input and output buffers are wiped once a chunk is written.
+//
+// usage: rekey_migrate -in old.bin -out new.bin [-target keygen|shared]
+//                      [-key name] [-threads T] [-chunk C]
+//        rekey_migrate -generate N -out old.bin [-errors E]
+//
+// Input:  "FZENROL1", then records id[16] | w'[436] | helper[96] | pk | sk.
+// Output: "FZREKEY1" | target (1 byte) | system key id[16] (zero for keygen),
+//         then records id[16] | status (1 byte, 0 = ok) | helper[96]
+//         [| pk | sk for -target keygen]. Failed records keep their slot with
+//         zeroed key material so that ids stay aligned with the input.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+static LARGE_INTEGER g_qpc_freq;
+static void init_timer(void) {
+    QueryPerformanceFrequency(&g_qpc_freq);
+}
+static double now_usec(void) {
+    LARGE_INTEGER cnt;
+    QueryPerformanceCounter(&cnt);
+    return (double)cnt.QuadPart * 1e6 / (double)g_qpc_freq.QuadPart;
+}
+static int cpu_count(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (int)si.dwNumberOfProcessors;
+}
+#else
+#include <sys/time.h>
+#include <unistd.h>
+static void init_timer(void) { }
+static double now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec * 1e6 + (double)tv.tv_usec;
+}
+static int cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+}
+#endif
+
+#include "../fuzzy_extractor.h"
+
+#define SYS_N_BYTES FUZZY_TEMPLATE_BYTES
+#define HELPER_LEN MCELIECE_348864F_CIPHERTEXT_LEN
+#define PK_LEN MCELIECE_348864F_PUBLIC_KEY_LEN
+#define SK_LEN MCELIECE_348864F_SECRET_KEY_LEN
+#define ID_LEN 16
+
+#define IN_MAGIC "FZENROL1"
+#define OUT_MAGIC "FZREKEY1"
+#define MAGIC_LEN 8
+
+#define TARGET_KEYGEN 0
+#define TARGET_SHARED 1
+
+/* Record layouts (packed, no padding). */
+#define IN_WPRIME_OFF ID_LEN
+#define IN_HELPER_OFF (IN_WPRIME_OFF + SYS_N_BYTES)
+#define IN_PK_OFF (IN_HELPER_OFF + HELPER_LEN)
+#define IN_SK_OFF (IN_PK_OFF + PK_LEN)
+#define IN_REC_LEN (IN_SK_OFF + SK_LEN)
+
+#define OUT_STATUS_OFF ID_LEN
+#define OUT_HELPER_OFF (OUT_STATUS_OFF + 1)
+#define OUT_PK_OFF (OUT_HELPER_OFF + HELPER_LEN)
+#define OUT_SK_OFF (OUT_PK_OFF + PK_LEN)
+#define OUT_REC_LEN_SHARED OUT_PK_OFF
+#define OUT_REC_LEN_KEYGEN (OUT_SK_OFF + SK_LEN)
+
+typedef struct {
+    int target;
+    const fuzzy_system_key *sys;
+    const uint8_t *in;      /* current input chunk */
+    uint8_t *out;           /* output chunk */
+    size_t out_rec_len;
+} migrate_ctx_t;
+
+typedef struct {
+    migrate_ctx_t *ctx;
+    size_t index;
+} migrate_job_t;
+
+static void rekey_task(void *arg, int node, void *scratch, size_t scratch_len) {
+    migrate_job_t *job = (migrate_job_t *)arg;
+    migrate_ctx_t *ctx = job->ctx;
+    const uint8_t *rec = ctx->in + job->index * IN_REC_LEN;
+    uint8_t *out = ctx->out + job->index * ctx->out_rec_len;
+    int rc;
+    (void)node; (void)scratch; (void)scratch_len;
+
+    memcpy(out, rec, ID_LEN);
+    if (ctx->target == TARGET_KEYGEN) {
+        rc = code_offset_rekey_keygen(rec + IN_WPRIME_OFF, SYS_N_BYTES,
+                                      rec + IN_HELPER_OFF, rec + IN_PK_OFF, rec + IN_SK_OFF,
+                                      out + OUT_HELPER_OFF, out + OUT_PK_OFF, out + OUT_SK_OFF,
+                                      NULL, 0);
+    } else {
+        rc = code_offset_rekey_shared(rec + IN_WPRIME_OFF, SYS_N_BYTES,
+                                      rec + IN_HELPER_OFF, rec + IN_PK_OFF, rec + IN_SK_OFF,
+                                      ctx->sys, out + OUT_HELPER_OFF, NULL, 0);
+    }
+    if (rc != 0) {
+        memset(out + OUT_HELPER_OFF, 0, ctx->out_rec_len - OUT_HELPER_OFF);
+    }
+    out[OUT_STATUS_OFF] = (uint8_t)(rc == 0 ? 0 : 1);
+}
+
+#define READ_ERROR ((size_t)-1)
+
+/* Whole records read (0 at end of file), or READ_ERROR when the file ends
+ * inside a record or cannot be read. */
+static size_t read_chunk(FILE *f, uint8_t *buf, size_t max_records) {
+    size_t bytes = fread(buf, 1, max_records * IN_REC_LEN, f);
+    if (ferror(f) || bytes % IN_REC_LEN != 0) return READ_ERROR;
+    return bytes / IN_REC_LEN;
+}
+
+/* -generate: per-record keypairs, w' = w with `errors` spread bit flips. */
+static int generate(const char *out_path, size_t count, int errors) {
+    FILE *f = fopen(out_path, "wb");
+    uint8_t *rec = (uint8_t *)malloc(IN_REC_LEN);
+    uint8_t w[SYS_N_BYTES], key[MCELIECE_348864F_SHARED_SECRET_LEN];
+    if (!f || !rec) { fprintf(stderr, "cannot open %s\n", out_path); free(rec); if (f) fclose(f); return 2; }
+
+    fwrite(IN_MAGIC, 1, MAGIC_LEN, f);
+    for (size_t r = 0; r < count; r++) {
+        memset(rec, 0, ID_LEN);
+        for (int b = 0; b < 8; b++) rec[b] = (uint8_t)((uint64_t)r >> (8 * b));
+        for (size_t i = 0; i < SYS_N_BYTES; i++) w[i] = (uint8_t)rand();
+        if (code_offset_encode(w, SYS_N_BYTES, rec + IN_HELPER_OFF, rec + IN_PK_OFF, rec + IN_SK_OFF,
+                               key, sizeof(key)) != 0) {
+            fprintf(stderr, "code_offset_encode fail\n");
+            break;
+        }
+        memcpy(rec + IN_WPRIME_OFF, w, SYS_N_BYTES);
+        for (int i = 0; i < errors; i++) {
+            int pos = (int)((r * 211 + (size_t)i * 107) % (SYS_N_BYTES * 8));
+            rec[IN_WPRIME_OFF + pos / 8] ^= (uint8_t)(1u << (pos % 8));
+        }
+        fwrite(rec, 1, IN_REC_LEN, f);
+    }
+
+    secure_memzero(rec, IN_REC_LEN);
+    secure_memzero(w, sizeof(w));
+    secure_memzero(key, sizeof(key));
+    free(rec);
+    fclose(f);
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s -in old.bin -out new.bin [-target keygen|shared] [-key name]\n"
+            "          [-threads T] [-chunk C]\n"
+            "       %s -generate N -out old.bin [-errors E]\n", argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *in_path = NULL, *out_path = NULL, *key_name = NULL;
+    int target = TARGET_KEYGEN;
+    int threads = cpu_count();
+    size_t chunk = 0;
+    long gen_count = -1;
+    int errors = 20;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (v == NULL) { usage(argv[0]); return 1; }
+        if (strcmp(a, "-in") == 0) in_path = v;
+        else if (strcmp(a, "-out") == 0) out_path = v;
+        else if (strcmp(a, "-target") == 0) {
+            if (strcmp(v, "keygen") == 0) target = TARGET_KEYGEN;
+            else if (strcmp(v, "shared") == 0) target = TARGET_SHARED;
+            else { fprintf(stderr, "unknown -target '%s'\n", v); usage(argv[0]); return 1; }
+        }
+        else if (strcmp(a, "-key") == 0) key_name = v;
+        else if (strcmp(a, "-threads") == 0) threads = atoi(v);
+        else if (strcmp(a, "-chunk") == 0) chunk = (size_t)atoi(v);
+        else if (strcmp(a, "-generate") == 0) gen_count = atol(v);
+        else if (strcmp(a, "-errors") == 0) errors = atoi(v);
+        else { usage(argv[0]); return 1; }
+        i++;
+    }
+    if (out_path == NULL) { usage(argv[0]); return 1; }
+    if (gen_count >= 0) return generate(out_path, (size_t)gen_count, errors);
+    if (in_path == NULL) { usage(argv[0]); return 1; }
+    if (threads < 1) threads = 1;
+    if (chunk < 1) chunk = 4 * (size_t)threads;
+
+    init_timer();
+
+    fuzzy_system_key *sys = NULL;
+    uint8_t key_id[FUZZY_SYSTEM_KEY_ID_LEN];
+    memset(key_id, 0, sizeof(key_id));
+    if (target == TARGET_SHARED) {
+        if (key_name == NULL) { fprintf(stderr, "-target shared needs -key name\n"); return 1; }
+        if (fuzzy_system_key_attach(&sys, key_name) != 0) {
+            fprintf(stderr, "cannot attach system key %s\n", key_name);
+            return 2;
+        }
+        fuzzy_system_key_id(sys, key_id);
+    }
+
+    FILE *fin = fopen(in_path, "rb");
+    FILE *fout = fopen(out_path, "wb");
+    char magic[MAGIC_LEN];
+    if (!fin || !fout) { fprintf(stderr, "cannot open input/output\n"); return 2; }
+    if (fread(magic, 1, MAGIC_LEN, fin) != MAGIC_LEN || memcmp(magic, IN_MAGIC, MAGIC_LEN) != 0) {
+        fprintf(stderr, "%s: not an enrollment file\n", in_path);
+        return 2;
+    }
+
+    /* Two input chunks (one being re-keyed, one being read) and one output chunk. */
+    migrate_ctx_t ctx;
+    ctx.target = target;
+    ctx.sys = sys;
+    ctx.out_rec_len = (target == TARGET_KEYGEN) ? OUT_REC_LEN_KEYGEN : OUT_REC_LEN_SHARED;
+    uint8_t *in_buf[2];
+    in_buf[0] = (uint8_t *)malloc(chunk * IN_REC_LEN);
+    in_buf[1] = (uint8_t *)malloc(chunk * IN_REC_LEN);
+    ctx.out = (uint8_t *)malloc(chunk * ctx.out_rec_len);
+    migrate_job_t *jobs = (migrate_job_t *)calloc(chunk, sizeof(migrate_job_t));
+    if (!in_buf[0] || !in_buf[1] || !ctx.out || !jobs) { fprintf(stderr, "alloc fail\n"); return 2; }
+
+    int nnodes = fuzzy_numa_node_count();
+    int threads_per_node = (threads + nnodes - 1) / nnodes;
+    fuzzy_numa_pool *pool = NULL;
+    if (fuzzy_numa_pool_create(&pool, threads_per_node, chunk, 0) != 0) {
+        fprintf(stderr, "pool create fail\n");
+        return 2;
+    }
+
+    uint8_t target_byte = (uint8_t)target;
+    fwrite(OUT_MAGIC, 1, MAGIC_LEN, fout);
+    fwrite(&target_byte, 1, 1, fout);
+    fwrite(key_id, 1, sizeof(key_id), fout);
+
+    fprintf(stderr, "[rekey] target=%s threads=%d chunk=%zu (%.1f MB buffered)\n",
+            target == TARGET_KEYGEN ? "keygen" : "shared", threads_per_node * nnodes, chunk,
+            (double)chunk * (2.0 * IN_REC_LEN + (double)ctx.out_rec_len) / 1e6);
+
+    uint64_t total = 0, failed = 0;
+    int truncated = 0;
+    int cur = 0;
+    double t0 = now_usec();
+    size_t n = read_chunk(fin, in_buf[cur], chunk);
+    if (n == READ_ERROR) {
+        truncated = 1;
+        n = 0;
+    }
+    while (n > 0) {
+        ctx.in = in_buf[cur];
+        for (size_t i = 0; i < n; i++) {
+            jobs[i].ctx = &ctx;
+            jobs[i].index = i;
+            fuzzy_numa_pool_submit(pool, -1, rekey_task, &jobs[i]);
+        }
+        size_t next = read_chunk(fin, in_buf[cur ^ 1], chunk);
+        if (next == READ_ERROR) {
+            truncated = 1;
+            next = 0;
+        }
+        fuzzy_numa_pool_wait(pool);
+
+        for (size_t i = 0; i < n; i++) failed += ctx.out[i * ctx.out_rec_len + OUT_STATUS_OFF] != 0;
+        total += n;
+        if (fwrite(ctx.out, ctx.out_rec_len, n, fout) != n) {
+            fprintf(stderr, "write error\n");
+            break;
+        }
+        secure_memzero(ctx.out, n * ctx.out_rec_len);
+        secure_memzero(in_buf[cur], n * IN_REC_LEN);
+        cur ^= 1;
+        n = next;
+    }
+    double secs = (now_usec() - t0) / 1e6;
+    if (truncated) {
+        fprintf(stderr, "%s: read error or partial record after %llu whole records\n",
+                in_path, (unsigned long long)total);
+    }
+
+    fuzzy_numa_pool_destroy(pool);
+    secure_memzero(in_buf[0], chunk * IN_REC_LEN);
+    secure_memzero(in_buf[1], chunk * IN_REC_LEN);
+    free(in_buf[0]); free(in_buf[1]); free(ctx.out); free(jobs);
+    fclose(fin);
+    fclose(fout);
+    if (sys != NULL) fuzzy_system_key_release(sys);
+
+    printf("records,failed,seconds,records_per_s\n");
+    printf("%llu,%llu,%.3f,%.1f\n", (unsigned long long)total, (unsigned long long)failed, secs,
+           secs > 0.0 ? (double)total / secs : 0.0);
+    if (truncated) return 2;
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../fuzzy_extractor.h"
+
+#define N_FEATURES 4101   /* deliberately not a multiple of 8 */
+#define N_SELECT 3000
+#define N_BATCH 4
+#define KEY_LEN 32
+
+/* Bit-by-bit reference: select, compare, pack LSB-first. */
+static void ref_binarize_f32(uint8_t *e, const float *x, const float *thr,
+                             const uint8_t *mask, size_t n) {
+    size_t pos = 0;
+    memset(e, 0, FUZZY_TEMPLATE_BYTES);
+    for (size_t i = 0; i < n; i++) {
+        if (mask && !((mask[i / 8] >> (i % 8)) & 1)) continue;
+        if (x[i] > thr[i]) e[pos / 8] |= (uint8_t)(1u << (pos % 8));
+        pos++;
+    }
+}
+
+static void ref_binarize_i16(uint8_t *e, const int16_t *x, const int16_t *thr,
+                             const uint8_t *mask, size_t n) {
+    size_t pos = 0;
+    memset(e, 0, FUZZY_TEMPLATE_BYTES);
+    for (size_t i = 0; i < n; i++) {
+        if (mask && !((mask[i / 8] >> (i % 8)) & 1)) continue;
+        if (x[i] > thr[i]) e[pos / 8] |= (uint8_t)(1u << (pos % 8));
+        pos++;
+    }
+}
+
+static float frand(void) {
+    return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+int main(void) {
+    static float xf[N_BATCH * N_FEATURES];
+    static float thr_f[N_FEATURES];
+    static int16_t xi[N_BATCH * N_FEATURES];
+    static int16_t thr_i[N_FEATURES];
+    static uint8_t mask[(N_FEATURES + 7) / 8];
+    static uint8_t e_ref[FUZZY_TEMPLATE_BYTES];
+    static uint8_t e_out[N_BATCH * FUZZY_TEMPLATE_BYTES];
+    int fail = 0;
+
+    srand(1234);
+    for (size_t i = 0; i < N_FEATURES; i++) {
+        thr_f[i] = frand() * 0.25f;
+        thr_i[i] = (int16_t)(rand() % 512 - 256);
+    }
+    for (size_t i = 0; i < N_BATCH * N_FEATURES; i++) {
+        xf[i] = frand();
+        xi[i] = (int16_t)(rand() % 65536 - 32768);
+    }
+
+    /* 1. Reliable mask selects exactly N_SELECT features. */
+    if (fuzzy_reliable_mask_f32(mask, xf, 1, thr_f, N_FEATURES, N_SELECT) != 0) {
+        printf("[FAIL] fuzzy_reliable_mask_f32\n"); return 1;
+    }
+    size_t selected = 0;
+    for (size_t i = 0; i < N_FEATURES; i++) selected += (mask[i / 8] >> (i % 8)) & 1;
+    printf("[%s] reliable mask selects %zu/%d\n", selected == N_SELECT ? "OK" : "FAIL", selected, N_SELECT);
+    fail += (selected != N_SELECT);
+
+    /* 2. Single-sample and batch paths match the reference (float). */
+    fuzzy_binarize_f32_batch(e_out, xf, N_BATCH, thr_f, mask, N_FEATURES);
+    for (size_t s = 0; s < N_BATCH; s++) {
+        ref_binarize_f32(e_ref, xf + s * N_FEATURES, thr_f, mask, N_FEATURES);
+        int ok = memcmp(e_ref, e_out + s * FUZZY_TEMPLATE_BYTES, FUZZY_TEMPLATE_BYTES) == 0;
+        printf("[%s] f32 batch sample %zu matches reference\n", ok ? "OK" : "FAIL", s);
+        fail += !ok;
+    }
+    uint8_t e_single[FUZZY_TEMPLATE_BYTES];
+    fuzzy_binarize_f32(e_single, xf, thr_f, mask, N_FEATURES);
+    fail += memcmp(e_single, e_out, FUZZY_TEMPLATE_BYTES) != 0;
+
+    /* 3. Same for int16, with the mask built from int16 data. */
+    int rc = fuzzy_reliable_mask_i16(mask, xi, N_BATCH, thr_i, N_FEATURES, N_SELECT);
+    selected = 0;
+    for (size_t i = 0; i < N_FEATURES; i++) selected += (mask[i / 8] >> (i % 8)) & 1;
+    int ok_mask = (rc == 0 && selected == N_SELECT);
+    printf("[%s] i16 reliable mask selects %zu/%d (rc=%d)\n", ok_mask ? "OK" : "FAIL", selected, N_SELECT, rc);
+    fail += !ok_mask;
+    fuzzy_binarize_i16_batch(e_out, xi, N_BATCH, thr_i, mask, N_FEATURES);
+    for (size_t s = 0; s < N_BATCH; s++) {
+        ref_binarize_i16(e_ref, xi + s * N_FEATURES, thr_i, mask, N_FEATURES);
+        int ok = memcmp(e_ref, e_out + s * FUZZY_TEMPLATE_BYTES, FUZZY_TEMPLATE_BYTES) == 0;
+        printf("[%s] i16 batch sample %zu matches reference\n", ok ? "OK" : "FAIL", s);
+        fail += !ok;
+    }
+
+    /* 4. Selecting more than FUZZY_TEMPLATE_BITS features is rejected. */
+    rc = fuzzy_binarize_f32(e_single, xf, thr_f, NULL, N_FEATURES);
+    printf("[%s] oversized selection rejected (rc=%d)\n", rc != 0 ? "OK" : "FAIL", rc);
+    fail += (rc == 0);
+
+    /* 5. Code-offset round trip through the float front-end, with a probe
+     * whose first 20 selected features are mirrored across their threshold. */
+    uint8_t *pk = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    uint8_t *sk = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t key1[KEY_LEN], key2[KEY_LEN];
+    if (!pk || !sk) { printf("alloc fail\n"); return 2; }
+
+    if (fuzzy_reliable_mask_f32(mask, xf, 1, thr_f, N_FEATURES, N_SELECT) != 0) {
+        printf("[FAIL] fuzzy_reliable_mask_f32\n"); return 1;
+    }
+    rc = code_offset_encode_f32(xf, thr_f, mask, N_FEATURES, helper, pk, sk, key1, KEY_LEN);
+    if (rc != 0) { printf("[FAIL] code_offset_encode_f32 rc=%d\n", rc); return 1; }
+
+    static float probe[N_FEATURES];
+    memcpy(probe, xf, sizeof(probe));
+    int flipped = 0;
+    for (size_t i = 0; i < N_FEATURES && flipped < 20; i++) {
+        if (!((mask[i / 8] >> (i % 8)) & 1)) continue;
+        probe[i] = 2.0f * thr_f[i] - probe[i];   /* mirror across threshold */
+        if ((probe[i] > thr_f[i]) != (xf[i] > thr_f[i])) flipped++;
+    }
+    rc = code_offset_decode_f32(probe, thr_f, mask, N_FEATURES, helper, pk, sk, key2, KEY_LEN);
+    int match = (rc == 0 && memcmp(key1, key2, KEY_LEN) == 0);
+    printf("[%s] f32 front-end decode with %d flipped bits\n", match ? "OK" : "FAIL", flipped);
+    fail += !match;
+
+    free(pk); free(sk);
+    printf("\nSummary: %d fail\n", fail);
+    return (fail == 0) ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../fuzzy_extractor.h"
+
+#define KEY_LEN 32
+#define TEMPLATE_LEN FUZZY_TEMPLATE_BYTES
+#define MAX_K 7
+
+/* Bit-by-bit reference for the weighted vote with capture-0 tie-break. */
+static void ref_fuse(uint8_t *out, uint8_t caps[][TEMPLATE_LEN], const uint8_t *weights, size_t k, size_t wlen) {
+    uint32_t total = 0;
+    for (size_t c = 0; c < k; c++) total += weights ? weights[c] : 1u;
+    memset(out, 0, wlen);
+    for (size_t pos = 0; pos < wlen * 8; pos++) {
+        uint32_t sum = 0;
+        for (size_t c = 0; c < k; c++) {
+            if ((caps[c][pos / 8] >> (pos % 8)) & 1) sum += weights ? weights[c] : 1u;
+        }
+        int bit = (2 * sum > total) || (2 * sum == total && ((caps[0][pos / 8] >> (pos % 8)) & 1));
+        if (bit) out[pos / 8] |= (uint8_t)(1u << (pos % 8));
+    }
+}
+
+/* Flip `n` bits of capture c, spread so that different captures hit different bits. */
+static void add_errors(uint8_t *cap, int c, int n) {
+    for (int i = 0; i < n; i++) {
+        int pos = (c * 1009 + i * 43) % (TEMPLATE_LEN * 8);
+        cap[pos / 8] ^= (uint8_t)(1u << (pos % 8));
+    }
+}
+
+int main(void) {
+    static uint8_t caps[MAX_K][TEMPLATE_LEN];
+    const uint8_t *ptrs[MAX_K];
+    uint8_t fused[TEMPLATE_LEN], ref[TEMPLATE_LEN];
+    uint8_t weights[MAX_K] = { 200, 10, 90, 255, 1, 64, 33 };
+    int fail = 0;
+
+    for (size_t c = 0; c < MAX_K; c++) {
+        for (size_t i = 0; i < TEMPLATE_LEN; i++) caps[c][i] = (uint8_t)rand();
+        ptrs[c] = caps[c];
+    }
+
+    /* 1. Majority and weighted vote match the reference for k = 1..MAX_K,
+     * including an odd length that exercises the partial tail block. */
+    for (size_t k = 1; k <= MAX_K; k++) {
+        for (int weighted = 0; weighted < 2; weighted++) {
+            size_t wlen = (k % 2) ? TEMPLATE_LEN : 101;
+            fuzzy_fuse_captures(fused, ptrs, weighted ? weights : NULL, k, wlen);
+            ref_fuse(ref, caps, weighted ? weights : NULL, k, wlen);
+            int ok = memcmp(fused, ref, wlen) == 0;
+            if (!ok) printf("[FAIL] k=%zu weighted=%d wlen=%zu: fused vote differs from reference\n", k, weighted, wlen);
+            fail += !ok;
+        }
+    }
+    printf("[%s] bitsliced vote matches reference\n", fail == 0 ? "OK" : "FAIL");
+
+    /* 2. Three captures with 90 errors each: every single decode is beyond
+     * SYS_T, the fused vector is error-free. */
+    uint8_t *pk = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    uint8_t *sk = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t w[TEMPLATE_LEN], key_ref[KEY_LEN], key_out[KEY_LEN];
+    if (!pk || !sk) { printf("alloc fail\n"); return 2; }
+
+    for (size_t i = 0; i < TEMPLATE_LEN; i++) w[i] = (uint8_t)rand();
+    if (code_offset_encode(w, TEMPLATE_LEN, helper, pk, sk, key_ref, KEY_LEN) != 0) {
+        printf("[FAIL] encode\n"); return 1;
+    }
+    for (int c = 0; c < 3; c++) {
+        memcpy(caps[c], w, TEMPLATE_LEN);
+        add_errors(caps[c], c, 90);
+    }
+
+    int attempts = 0;
+    int rc = code_offset_decode_fused(ptrs, NULL, 3, TEMPLATE_LEN, FUZZY_FUSE_ONLY,
+                                      helper, pk, sk, key_out, KEY_LEN, &attempts);
+    int ok = (rc == 0 && attempts == 1 && memcmp(key_ref, key_out, KEY_LEN) == 0);
+    printf("[%s] 3 x 90 errors: fused decode succeeds in %d attempt(s)\n", ok ? "OK" : "FAIL", attempts);
+    fail += !ok;
+
+    /* 3. Fallback: two captures that disagree everywhere they are wrong
+     * (tie -> capture 0, which has 100 errors) but capture 1 alone is fine.
+     * The fused vector equals capture 0, so its retry is skipped. */
+    memcpy(caps[0], w, TEMPLATE_LEN);
+    add_errors(caps[0], 0, 100);
+    memcpy(caps[1], w, TEMPLATE_LEN);
+    add_errors(caps[1], 1, 20);
+    rc = code_offset_decode_fused(ptrs, NULL, 2, TEMPLATE_LEN, FUZZY_FUSE_FALLBACK,
+                                  helper, pk, sk, key_out, KEY_LEN, &attempts);
+    ok = (rc == 0 && attempts == 2 && memcmp(key_ref, key_out, KEY_LEN) == 0);
+    printf("[%s] fallback recovers from capture 1 after %d attempts (rc=%d)\n", ok ? "OK" : "FAIL", attempts, rc);
+    fail += !ok;
+
+    free(pk); free(sk);
+    printf("\nSummary: %d fail\n", fail);
+    return (fail == 0) ? 0 : 1;
+}
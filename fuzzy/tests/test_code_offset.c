@@ -13,9 +13,11 @@ int main(void) {
     uint8_t key1[KEY_LEN];
     uint8_t key2[KEY_LEN];
 
-    uint8_t pk[MCELIECE_348864F_PUBLIC_KEY_LEN];
-    uint8_t sk[MCELIECE_348864F_SECRET_KEY_LEN];
+    /* Keys on the heap: the 261 KB public key does not fit small stacks. */
+    uint8_t *pk = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    uint8_t *sk = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
     uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    if (!pk || !sk) { fprintf(stderr, "alloc fail\n"); return 1; }
 
     /* create a random template w */
     uint8_t w[KEY_LEN];
@@ -29,7 +31,7 @@ int main(void) {
     }
 
     printf("test_code_offset: calling code_offset_decode\n"); fflush(stdout);
-    rc = code_offset_decode(w, KEY_LEN, helper, sk, key2, KEY_LEN);
+    rc = code_offset_decode(w, KEY_LEN, helper, pk, sk, key2, KEY_LEN);
     if (rc != 0) {
         fprintf(stderr, "decode failed: %d\n", rc);
         return 3;
@@ -40,6 +42,23 @@ int main(void) {
         return 4;
     }
 
+    /* Low-stack variants: same helper and key with the working set in scratch. */
+    uint8_t scratch[CODE_OFFSET_SCRATCH_BYTES];
+    uint8_t helper2[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t key3[KEY_LEN];
+    printf("test_code_offset: calling code_offset_encode_scratch / _decode_scratch\n"); fflush(stdout);
+    rc = code_offset_encode_scratch(w, KEY_LEN, helper2, pk, key3, KEY_LEN, scratch, sizeof(scratch));
+    if (rc != 0 || memcmp(helper, helper2, sizeof(helper)) != 0 || memcmp(key1, key3, KEY_LEN) != 0) {
+        fprintf(stderr, "encode_scratch mismatch: rc=%d\n", rc);
+        return 5;
+    }
+    rc = code_offset_decode_scratch(w, KEY_LEN, helper, pk, sk, key3, KEY_LEN, scratch, sizeof(scratch));
+    if (rc != 0 || memcmp(key1, key3, KEY_LEN) != 0) {
+        fprintf(stderr, "decode_scratch mismatch: rc=%d\n", rc);
+        return 6;
+    }
+
     printf("Code-offset encode/decode success. key_len=%zu\n", KEY_LEN);
+    free(pk); free(sk);
     return 0;
 }
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../fuzzy_extractor.h"
+
+#define KEY_LEN 32
+#define TEMPLATE_LEN FUZZY_TEMPLATE_BYTES
+
+static double now_usec(void) {
+    return (double)clock() * 1e6 / (double)CLOCKS_PER_SEC;
+}
+
+/* Stream w' in pseudo-random chunk sizes (1..max_chunk bytes). */
+static int stream_decode(const uint8_t *wprime, size_t wlen, size_t max_chunk,
+                         const uint8_t *helper, const uint8_t *pk, const uint8_t *sk,
+                         uint8_t *key_out, double *final_us) {
+    code_offset_decode_ctx ctx;
+    if (code_offset_decode_init(&ctx, helper, pk, sk) != 0) return -1;
+    size_t off = 0;
+    while (off < wlen) {
+        size_t n = 1 + (size_t)rand() % max_chunk;
+        if (n > wlen - off) n = wlen - off;
+        if (code_offset_decode_update(&ctx, wprime + off, n) != 0) return -1;
+        off += n;
+    }
+    double t0 = now_usec();
+    int rc = code_offset_decode_final(&ctx, key_out, KEY_LEN);
+    *final_us = now_usec() - t0;
+    return rc;
+}
+
+int main(void) {
+    uint8_t *pk = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    uint8_t *sk = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t w[TEMPLATE_LEN], wprime[TEMPLATE_LEN + 16];
+    uint8_t key_ref[KEY_LEN], key_one[KEY_LEN], key_stream[KEY_LEN];
+    const size_t chunk_sizes[] = { 1, 7, 64, 97, TEMPLATE_LEN };
+    int fail = 0;
+
+    if (!pk || !sk) { printf("alloc fail\n"); return 2; }
+
+    for (size_t i = 0; i < TEMPLATE_LEN; i++) w[i] = (uint8_t)rand();
+    if (code_offset_encode(w, TEMPLATE_LEN, helper, pk, sk, key_ref, KEY_LEN) != 0) {
+        printf("[FAIL] encode\n"); return 1;
+    }
+
+    for (int errors = 0; errors <= 64; errors += 16) {
+        memcpy(wprime, w, TEMPLATE_LEN);
+        for (int i = 0; i < errors; i++) {
+            int pos = (i * 107) % (TEMPLATE_LEN * 8);   /* distinct for i < 3488 */
+            wprime[pos / 8] ^= (uint8_t)(1u << (pos % 8));
+        }
+        double t0 = now_usec();
+        int rc_one = code_offset_decode(wprime, TEMPLATE_LEN, helper, pk, sk, key_one, KEY_LEN);
+        double one_us = now_usec() - t0;
+
+        for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+            double final_us = 0.0;
+            int rc = stream_decode(wprime, TEMPLATE_LEN, chunk_sizes[c], helper, pk, sk, key_stream, &final_us);
+            int ok = (rc == rc_one) && (rc != 0 || memcmp(key_one, key_stream, KEY_LEN) == 0) &&
+                     (rc != 0 || memcmp(key_ref, key_stream, KEY_LEN) == 0);
+            printf("[%s] errors=%2d max_chunk=%3zu: stream rc=%d one-shot rc=%d (final %.0f us vs one-shot %.0f us)\n",
+                   ok ? "OK" : "FAIL", errors, chunk_sizes[c], rc, rc_one, final_us, one_us);
+            fail += !ok;
+        }
+    }
+
+    /* Short probe (zero-padded) and over-long probe (truncated) match one-shot. */
+    memcpy(wprime, w, TEMPLATE_LEN);
+    memset(wprime + TEMPLATE_LEN, 0xFF, 16);
+    size_t lens[] = { 100, TEMPLATE_LEN + 16 };
+    for (size_t k = 0; k < 2; k++) {
+        double final_us;
+        int rc_one = code_offset_decode(wprime, lens[k], helper, pk, sk, key_one, KEY_LEN);
+        int rc = stream_decode(wprime, lens[k], 13, helper, pk, sk, key_stream, &final_us);
+        int ok = (rc == rc_one) && (rc != 0 || memcmp(key_one, key_stream, KEY_LEN) == 0);
+        printf("[%s] wlen=%zu: stream matches one-shot (rc=%d)\n", ok ? "OK" : "FAIL", lens[k], rc);
+        fail += !ok;
+    }
+
+    free(pk); free(sk);
+    printf("\nSummary: %d fail\n", fail);
+    return (fail == 0) ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../fuzzy_extractor.h"
+
+#define KEY_LEN 32
+#define TEMPLATE_LEN FUZZY_TEMPLATE_BYTES
+
+static void add_errors(uint8_t *wprime, const uint8_t *w, int n, int salt) {
+    memcpy(wprime, w, TEMPLATE_LEN);
+    for (int i = 0; i < n; i++) {
+        int pos = (salt * 389 + i * 107) % (TEMPLATE_LEN * 8);
+        wprime[pos / 8] ^= (uint8_t)(1u << (pos % 8));
+    }
+}
+
+int main(void) {
+    uint8_t *pk_old = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    uint8_t *sk_old = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    uint8_t *pk_new = (uint8_t *)malloc(MCELIECE_348864F_PUBLIC_KEY_LEN);
+    uint8_t *sk_new = (uint8_t *)malloc(MCELIECE_348864F_SECRET_KEY_LEN);
+    uint8_t helper_old[MCELIECE_348864F_CIPHERTEXT_LEN], helper_new[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t helper_copy[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t w[TEMPLATE_LEN], wprime[TEMPLATE_LEN];
+    uint8_t key_ref[KEY_LEN], key_rekey[KEY_LEN], key_out[KEY_LEN];
+    int fail = 0;
+
+    if (!pk_old || !sk_old || !pk_new || !sk_new) { printf("alloc fail\n"); return 2; }
+
+    for (size_t i = 0; i < TEMPLATE_LEN; i++) w[i] = (uint8_t)rand();
+    if (code_offset_encode(w, TEMPLATE_LEN, helper_old, pk_old, sk_old, key_ref, KEY_LEN) != 0) {
+        printf("[FAIL] encode\n"); return 1;
+    }
+
+    /* 1. Re-key to a fresh key pair from a noisy sample; a second noisy sample
+     * decodes under the new pair to the original key. */
+    add_errors(wprime, w, 30, 1);
+    int rc = code_offset_rekey_keygen(wprime, TEMPLATE_LEN, helper_old, pk_old, sk_old,
+                                      helper_new, pk_new, sk_new, key_rekey, KEY_LEN);
+    int ok = (rc == 0 && memcmp(key_ref, key_rekey, KEY_LEN) == 0);
+    add_errors(wprime, w, 30, 2);
+    ok = ok && code_offset_decode(wprime, TEMPLATE_LEN, helper_new, pk_new, sk_new, key_out, KEY_LEN) == 0 &&
+         memcmp(key_ref, key_out, KEY_LEN) == 0;
+    printf("[%s] rekey_keygen: new helper decodes to the enrolled key (rc=%d)\n", ok ? "OK" : "FAIL", rc);
+    fail += !ok;
+
+    /* 2. Re-key onto a shared system key, key_out omitted. */
+    fuzzy_system_key *sys = NULL;
+    if (fuzzy_system_key_create(&sys, NULL) != 0) { printf("[FAIL] fuzzy_system_key_create\n"); return 1; }
+    add_errors(wprime, w, 20, 3);
+    rc = code_offset_rekey_shared(wprime, TEMPLATE_LEN, helper_old, pk_old, sk_old, sys, helper_new, NULL, 0);
+    add_errors(wprime, w, 20, 4);
+    ok = (rc == 0) && code_offset_decode_shared(sys, wprime, TEMPLATE_LEN, helper_new, key_out, KEY_LEN) == 0 &&
+         memcmp(key_ref, key_out, KEY_LEN) == 0;
+    printf("[%s] rekey_shared: system-key helper decodes to the enrolled key (rc=%d)\n", ok ? "OK" : "FAIL", rc);
+    fail += !ok;
+
+    /* 3. Across a rotation of that system key: a helper enrolled under
+     * generation 1 moves to generation 2 through the retired generation. */
+    uint8_t key_sys[KEY_LEN];
+    uint8_t helper_sys[MCELIECE_348864F_CIPHERTEXT_LEN];
+    ok = code_offset_encode_shared(sys, w, TEMPLATE_LEN, helper_sys, key_sys, KEY_LEN) == 0 &&
+         fuzzy_system_key_rotate(sys) == 0;
+    add_errors(wprime, w, 25, 6);
+    rc = code_offset_rekey_system(wprime, TEMPLATE_LEN, helper_sys, fuzzy_system_key_retired(sys), sys,
+                                  helper_new, key_rekey, KEY_LEN);
+    ok = ok && (rc == 0) && memcmp(key_sys, key_rekey, KEY_LEN) == 0;
+    fuzzy_system_key_release_retired(sys);
+    add_errors(wprime, w, 25, 7);
+    ok = ok && code_offset_decode_shared(sys, wprime, TEMPLATE_LEN, helper_new, key_out, KEY_LEN) == 0 &&
+         memcmp(key_sys, key_out, KEY_LEN) == 0;
+    printf("[%s] rekey_system: retired-generation helper decodes under the rotated key (rc=%d)\n",
+           ok ? "OK" : "FAIL", rc);
+    fail += !ok;
+
+    rc = code_offset_rekey_system(wprime, TEMPLATE_LEN, helper_sys, fuzzy_system_key_retired(sys), sys,
+                                  helper_new, NULL, 0);
+    printf("[%s] rekey_system without a retired generation is rejected (rc=%d)\n", rc == -1 ? "OK" : "FAIL", rc);
+    fail += (rc != -1);
+    fuzzy_system_key_release(sys);
+
+    /* 4. A sample beyond SYS_T fails and leaves the output helper untouched. */
+    add_errors(wprime, w, 200, 5);
+    memset(helper_new, 0xA5, sizeof(helper_new));
+    memcpy(helper_copy, helper_new, sizeof(helper_new));
+    rc = code_offset_rekey(wprime, TEMPLATE_LEN, helper_old, pk_old, sk_old, pk_new, helper_new, key_out, KEY_LEN);
+    ok = (rc != 0 && memcmp(helper_new, helper_copy, sizeof(helper_new)) == 0);
+    printf("[%s] rekey with 200 errors is rejected (rc=%d)\n", ok ? "OK" : "FAIL", rc);
+    fail += !ok;
+
+    free(pk_old); free(sk_old); free(pk_new); free(sk_new);
+    printf("\nSummary: %d fail\n", fail);
+    return (fail == 0) ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: MIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "../fuzzy_extractor.h"
+
+#define KEY_LEN 32
+#define TEMPLATE_LEN FUZZY_TEMPLATE_BYTES
+
+static int enroll(const fuzzy_system_key *sys, const uint8_t *w, uint8_t *helper, uint8_t *key) {
+    return code_offset_encode_shared(sys, w, TEMPLATE_LEN, helper, key, KEY_LEN) == 0;
+}
+
+static int verify(const fuzzy_system_key *sys, const uint8_t *w, int flips,
+                  const uint8_t *helper, const uint8_t *key) {
+    uint8_t wprime[TEMPLATE_LEN];
+    uint8_t key2[KEY_LEN];
+
+    if (sys == NULL) return 0;
+    memcpy(wprime, w, TEMPLATE_LEN);
+    for (int i = 0; i < flips; i++) wprime[(i * 37) % TEMPLATE_LEN] ^= (uint8_t)(1u << (i % 8));
+    int rc = code_offset_decode_shared(sys, wprime, TEMPLATE_LEN, helper, key2, KEY_LEN);
+    return rc == 0 && memcmp(key, key2, KEY_LEN) == 0;
+}
+
+static int roundtrip(const fuzzy_system_key *enroll_key, const fuzzy_system_key *verify_key,
+                     const uint8_t *w, int flips) {
+    uint8_t helper[MCELIECE_348864F_CIPHERTEXT_LEN];
+    uint8_t key[KEY_LEN];
+    return enroll(enroll_key, w, helper, key) && verify(verify_key, w, flips, helper, key);
+}
+
+int main(void) {
+    uint8_t w[TEMPLATE_LEN];
+    uint8_t id1[FUZZY_SYSTEM_KEY_ID_LEN], id2[FUZZY_SYSTEM_KEY_ID_LEN];
+    uint8_t helper_old[MCELIECE_348864F_CIPHERTEXT_LEN], key_old[KEY_LEN];
+    int fail = 0;
+
+    for (size_t i = 0; i < sizeof(w); i++) w[i] = (uint8_t)rand();
+
+    /* 1. Process-local / memfd key: enroll and verify with 30 bit errors. */
+    fuzzy_system_key *owner = NULL;
+    int rc = fuzzy_system_key_create(&owner, NULL);
+    if (rc != 0) { printf("[FAIL] fuzzy_system_key_create rc=%d\n", rc); return 1; }
+
+    int ok = roundtrip(owner, owner, w, 30);
+    printf("[%s] unnamed system key: encode/decode with 30 errors\n", ok ? "OK" : "FAIL");
+    fail += !ok;
+
+#ifndef _WIN32
+    /* 2. A worker attaching by fd sees the same key read-only. */
+    int fd = fuzzy_system_key_fd(owner);
+    if (fd >= 0) {
+        fuzzy_system_key *worker = NULL;
+        rc = fuzzy_system_key_attach_fd(&worker, fd);
+        ok = (rc == 0) && roundtrip(owner, worker, w, 10);
+        printf("[%s] fd-attached worker decodes owner enrollment\n", ok ? "OK" : "FAIL");
+        fail += !ok;
+
+        /* Rotate with a helper enrolled under generation 1 outstanding. */
+        ok = (rc == 0) && enroll(owner, w, helper_old, key_old) && fuzzy_system_key_id(worker, id1) == 0;
+        rc = fuzzy_system_key_rotate(owner);
+        ok = ok && (rc == 0) && fuzzy_system_key_id(owner, id2) == 0 && memcmp(id1, id2, sizeof(id1)) != 0;
+        printf("[%s] rotate issues a new key id (rc=%d)\n", ok ? "OK" : "FAIL", rc);
+        fail += !ok;
+
+        ok = fuzzy_system_key_id(worker, id2) == 0 && memcmp(id1, id2, sizeof(id1)) == 0 &&
+             verify(worker, w, 10, helper_old, key_old);
+        printf("[%s] worker that has not refreshed still decodes a pre-rotation helper\n", ok ? "OK" : "FAIL");
+        fail += !ok;
+
+        const fuzzy_system_key *old = fuzzy_system_key_retired(owner);
+        ok = old != NULL && fuzzy_system_key_id(old, id2) == 0 && memcmp(id1, id2, sizeof(id1)) == 0 &&
+             verify(old, w, 10, helper_old, key_old);
+        printf("[%s] retired generation decodes a pre-rotation helper\n", ok ? "OK" : "FAIL");
+        fail += !ok;
+
+        rc = fuzzy_system_key_rotate(owner);
+        printf("[%s] rotate refuses while a retired generation is held (rc=%d)\n", rc == -1 ? "OK" : "FAIL", rc);
+        fail += (rc != -1);
+
+        rc = fuzzy_system_key_refresh(worker);
+        printf("[%s] fd-attached worker reports retired key (rc=%d)\n", rc == -1 ? "OK" : "FAIL", rc);
+        fail += (rc != -1);
+        fuzzy_system_key_release(worker);
+
+        fuzzy_system_key_release_retired(owner);
+        ok = fuzzy_system_key_retired(owner) == NULL && roundtrip(owner, owner, w, 10);
+        printf("[%s] release_retired drops the old generation, current key unaffected\n", ok ? "OK" : "FAIL");
+        fail += !ok;
+    }
+#endif
+    fuzzy_system_key_release(owner);
+
+#ifndef _WIN32
+    /* 3. Named segment: attach by name, rotate, refresh. */
+    char name[64];
+    snprintf(name, sizeof(name), "/fuzzy-test-%ld", (long)getpid());
+
+    rc = fuzzy_system_key_create(&owner, name);
+    if (rc != 0) { printf("[FAIL] named create rc=%d\n", rc); return 1; }
+
+    fuzzy_system_key *worker = NULL;
+    rc = fuzzy_system_key_attach(&worker, name);
+    ok = (rc == 0) && roundtrip(owner, worker, w, 64);
+    printf("[%s] named attach decodes with 64 errors\n", ok ? "OK" : "FAIL");
+    fail += !ok;
+
+    rc = fuzzy_system_key_refresh(worker);
+    printf("[%s] refresh before rotation is a no-op (rc=%d)\n", rc == 0 ? "OK" : "FAIL", rc);
+    fail += (rc != 0);
+
+    fuzzy_system_key_id(worker, id1);
+    ok = enroll(owner, w, helper_old, key_old);
+    rc = fuzzy_system_key_rotate(owner);
+    if (rc != 0) { printf("[FAIL] rotate rc=%d\n", rc); return 1; }
+    rc = fuzzy_system_key_refresh(worker);
+    fuzzy_system_key_id(worker, id2);
+    ok = ok && (rc == 1) && memcmp(id1, id2, sizeof(id1)) != 0 && roundtrip(owner, worker, w, 5);
+    printf("[%s] refresh after rotation picks up the new key (rc=%d)\n", ok ? "OK" : "FAIL", rc);
+    fail += !ok;
+
+    ok = verify(fuzzy_system_key_retired(worker), w, 5, helper_old, key_old);
+    printf("[%s] refreshed worker keeps the retired mapping for old helpers\n", ok ? "OK" : "FAIL");
+    fail += !ok;
+
+    /* A fresh attach by name sees the new generation. */
+    fuzzy_system_key *late = NULL;
+    rc = fuzzy_system_key_attach(&late, name);
+    ok = (rc == 0) && fuzzy_system_key_id(late, id1) == 0 && memcmp(id1, id2, sizeof(id1)) == 0;
+    printf("[%s] attach after rotation maps the published generation (rc=%d)\n", ok ? "OK" : "FAIL", rc);
+    fail += !ok;
+    fuzzy_system_key_release(late);
+
+    /* Second rotation once the first retired generation is released. */
+    fuzzy_system_key_release_retired(worker);
+    fuzzy_system_key_release_retired(owner);
+    rc = fuzzy_system_key_rotate(owner);
+    int rc2 = fuzzy_system_key_refresh(worker);
+    ok = (rc == 0) && (rc2 == 1) && roundtrip(owner, worker, w, 5);
+    printf("[%s] second rotation after release_retired (rc=%d, refresh=%d)\n", ok ? "OK" : "FAIL", rc, rc2);
+    fail += !ok;
+
+    fuzzy_system_key_release(worker);
+    fuzzy_system_key_release(owner);
+
+    rc = fuzzy_system_key_attach(&worker, name);
+    printf("[%s] name is unlinked after owner release (rc=%d)\n", rc != 0 ? "OK" : "FAIL", rc);
+    fail += (rc == 0);
+#endif
+
+    printf("\nSummary: %d fail\n", fail);
+    return (fail == 0) ? 0 : 1;
+}
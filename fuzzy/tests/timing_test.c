@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: MIT
 // Timing test for Code-Offset fuzzy extractor decode across bit flips 0..63
+// (also records the peak stack of one decode per row, see footprint.h)
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,6 +31,7 @@ static double now_usec(void) {
 #endif
 
 #include "../fuzzy_extractor.h"
+#include "footprint.h"
 
 /* Parameters for Classic McEliece 348864f */
 #define SYS_N_BITS 3488
@@ -72,6 +74,17 @@ static int cmp_double(const void *a, const void *b) {
     return (da > db) - (da < db);
 }
 
+typedef struct {
+    const uint8_t *wprime, *helper, *pk, *sk;
+    uint8_t *key_out;
+} decode_args_t;
+
+static void decode_once(void *arg) {
+    decode_args_t *d = (decode_args_t *)arg;
+    (void)code_offset_decode(d->wprime, SYS_N_BYTES, d->helper, d->pk, d->sk, d->key_out,
+                             MCELIECE_348864F_SHARED_SECRET_LEN);
+}
+
 typedef struct {
     int errors;
     int attempts;
@@ -81,6 +94,7 @@ typedef struct {
     double p05_us;
     double p95_us;
     double stddev_us;
+    size_t stack_bytes;
 } timing_row_t;
 
 static int cmp_row_errors(const void *a, const void *b) {
@@ -122,7 +136,7 @@ int main(int argc, char **argv) {
 
     FILE *csv = fopen("timing_results.csv", "wb");
     FILE *out = csv ? csv : stdout;
-    fprintf(out, "errors,attempts,success_rate,mean_us,median_us,p05_us,p95_us,stddev_us\n");
+    fprintf(out, "errors,attempts,success_rate,mean_us,median_us,p05_us,p95_us,stddev_us,stack_bytes\n");
     fflush(out);
 
     int attempts = 100;
@@ -203,6 +217,11 @@ int main(int argc, char **argv) {
         rows[idx].p95_us = p95;
         rows[idx].stddev_us = stddev;
 
+        /* Peak stack of one more decode at this weight (not timed). */
+        decode_args_t d = { wprime, helper, pk, sk, key_out };
+        rows[idx].stack_bytes = 0;
+        (void)footprint_stack_peak(decode_once, &d, &rows[idx].stack_bytes);
+
         fprintf(stderr, "[progress] done errors=%d: success_rate=%.3f mean_us=%.3f stddev_us=%.3f\n",
             errors, rows[idx].success_rate, rows[idx].mean_us, rows[idx].stddev_us);
         fflush(stderr);
@@ -212,7 +231,7 @@ int main(int argc, char **argv) {
 
     qsort(rows, 64, sizeof(rows[0]), cmp_row_errors);
     for (int i = 0; i < 64; i++) {
-        fprintf(out, "%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+        fprintf(out, "%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%zu\n",
                 rows[i].errors,
                 rows[i].attempts,
                 rows[i].success_rate,
@@ -220,7 +239,8 @@ int main(int argc, char **argv) {
                 rows[i].median_us,
                 rows[i].p05_us,
                 rows[i].p95_us,
-                rows[i].stddev_us);
+                rows[i].stddev_us,
+                rows[i].stack_bytes);
     }
     fflush(out);
 